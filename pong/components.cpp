@@ -29,4 +29,15 @@ struct PlayerSpeed {
 	float speed = 0.0f;
 };
 
+// Shapes are drawn centered on the rigid body of their entity
+struct RectangleShape {
+	vis::vec2 half_extent;
+	vis::vec4 color;
+};
+
+struct CircleShape {
+	float radius = 0.0f;
+	vis::vec4 color;
+};
+
 } // namespace Game
@@ -17,12 +17,10 @@ struct FollowingEvent {
 	float ball_y_pos;
 };
 
-struct KeyDownEvent {
-	vis::win::VirtualKey key;
-};
-
-struct KeyUpEvent {
+// Presses and releases share one event type, and so one queue, to reach the simulation in the order they happened
+struct KeyEvent {
 	vis::win::VirtualKey key;
+	bool pressed;
 };
 
 } // namespace Game
\ No newline at end of file
@@ -4,5 +4,9 @@ export import :events;
 export import :components;
 export import :constants;
 export import :scene;
+export import :trajectory;
+export import :simulation;
+export import :replay;
+export import :rollback;
 export import :app;
 export import :test_scene;
\ No newline at end of file
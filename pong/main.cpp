@@ -1,8 +1,75 @@
 import game;
+import std;
 import vis;
 
-auto on_init(void** appstate, [[maybe_unused]] int argc, [[maybe_unused]] char** argv) -> vis::app::AppResult {
-	*appstate = Game::App::create();
+auto on_init(void** appstate, int argc, char** argv) -> vis::app::AppResult {
+	const auto options = Game::parse_options(std::span{argv, static_cast<std::size_t>(argc)});
+
+	if (options.replay) {
+		try {
+			const auto result = Game::replay_match(*options.replay);
+			std::println("Replayed {} ticks in {}: player {} - computer {}", result.ticks, result.elapsed, result.games_won,
+									 result.games_lost);
+			return vis::app::AppResult::success;
+		} catch (const std::exception& exc) {
+			std::println("Unable to replay {}: {}", options.replay->string(), exc.what());
+			return vis::app::AppResult::failure;
+		}
+	}
+
+	if (options.loopback) {
+		const auto conditions = vis::net::LinkConditions{
+				.latency = vis::chrono::milliseconds{60.0f},
+				.jitter = vis::chrono::milliseconds{15.0f},
+				.loss = 0.05f,
+		};
+		const auto result = Game::run_loopback_match(conditions, 60 * 60, vis::make_random_seed());
+		const auto frame_budget = vis::chrono::milliseconds{1000.0f / 60.0f};
+		for (const auto& [side, stats] : {std::pair{"right", result.right}, std::pair{"left", result.left}}) {
+			std::println("{} peer: {} ticks, {} rollbacks, {} resimulated ticks (at most {} at once), {} stalls", side,
+									 stats.ticks, stats.rollbacks, stats.resimulated_ticks, stats.max_rollback, stats.stalls);
+			std::println("{} peer: {} per tick, {:.0f} ticks of resimulation fit in a {} frame", side, stats.average_tick(),
+									 stats.resimulation_capacity(frame_budget), frame_budget);
+			std::println("{} peer: {} checksums compared, {} desyncs{}", side, stats.checked_ticks, stats.desyncs,
+									 stats.first_desync_tick ? std::format(", the first at tick {}", *stats.first_desync_tick) : "");
+		}
+		std::println("completed: {}, in sync: {}", result.completed, result.in_sync);
+		return result.completed ? vis::app::AppResult::success : vis::app::AppResult::failure;
+	}
+
+	if (options.benchmark_restart) {
+		const auto [rebuild, reset] = Game::benchmark_restart();
+		std::println("Match restart: rebuild {}, reset in place {}", rebuild, reset);
+		return vis::app::AppResult::success;
+	}
+
+	if (options.benchmark_snapshot) {
+		constexpr auto body_counts = std::array{100uz, 1'000uz, 10'000uz};
+		for (const auto& [bodies, snapshot, restore] : vis::physics::benchmark_snapshot(body_counts))
+			std::println("{} bodies: snapshot {}, restore {}", bodies, snapshot, restore);
+		return vis::app::AppResult::success;
+	}
+
+	if (options.benchmark_math) {
+		std::println("Batch math with {} lanes of {}", vis::simd::lane_count, vis::simd::to_string(vis::simd::isa));
+		for (const auto& [kernel, scalar, batched] : vis::simd::benchmark_batch_math())
+			std::println("{}: glm {}, batched {}", kernel, scalar, batched);
+		return vis::app::AppResult::success;
+	}
+
+	if (options.benchmark_archive) {
+		try {
+			const auto result = vis::ecs::benchmark_archive();
+			std::println("Snapshot of {} entities, {} bytes: write {}, save {}, load {}", result.entity_count, result.bytes,
+									 result.write, result.save, result.load);
+			return vis::app::AppResult::success;
+		} catch (const std::exception& exc) {
+			std::println("Snapshot round trip failed: {}", exc.what());
+			return vis::app::AppResult::failure;
+		}
+	}
+
+	*appstate = Game::App::create(options);
 
 	if (*appstate == nullptr)
 		return vis::app::AppResult::failure;
@@ -15,11 +15,59 @@ import vis;
 export namespace Game {
 using namespace vis::literals::chrono_literals;
 
+struct Options {
+  // saves the seed and the input of the session
+  std::optional<std::filesystem::path> record;
+  // replays a recorded match headless instead of opening the window
+  std::optional<std::filesystem::path> replay;
+  // plays a headless rollback match between two bots over a lossy loopback link
+  bool loopback = false;
+  // compares rebuilding a match with resetting it in place
+  bool benchmark_restart = false;
+  // times capturing and restoring the physics world for a few body counts
+  bool benchmark_snapshot = false;
+  // compares the batch math kernels with glm
+  bool benchmark_math = false;
+  // writes a registry of a million entities to a snapshot file and reads it back
+  bool benchmark_archive = false;
+};
+
+// pong [--record <file>] [--replay <file>] [--loopback] [--benchmark-restart] [--benchmark-snapshot]
+//      [--benchmark-math] [--benchmark-archive]
+Options parse_options(std::span<char*> args) {
+  Options options;
+  for (auto arg = args.begin() + (args.empty() ? 0 : 1); arg != args.end(); ++arg) {
+    const auto name = std::string_view{*arg};
+    const auto has_value = std::next(arg) != args.end();
+    if (name == "--record" and has_value) {
+      options.record = *++arg;
+    } else if (name == "--replay" and has_value) {
+      options.replay = *++arg;
+    } else if (name == "--loopback") {
+      options.loopback = true;
+    } else if (name == "--benchmark-restart") {
+      options.benchmark_restart = true;
+    } else if (name == "--benchmark-snapshot") {
+      options.benchmark_snapshot = true;
+    } else if (name == "--benchmark-math") {
+      options.benchmark_math = true;
+    } else if (name == "--benchmark-archive") {
+      options.benchmark_archive = true;
+    } else {
+      std::println("Ignoring the unknown argument {}", name);
+    }
+  }
+  return options;
+}
+
 class App {
 public:
-  static App* create() {
+  static App* create(const Options& options = {}) {
+    // the startup times are relative to this first use of the trace
+    auto& startup_trace = vis::chrono::StartupTrace::global();
     try {
-      static auto app = new App{TITLE, SCREEN_WIDTH, SCREEN_HEIGHT};
+      const auto phase = startup_trace.measure("app");
+      static auto app = new App{TITLE, SCREEN_WIDTH, SCREEN_HEIGHT, options.record};
       return app;
     } catch (const std::exception& exc) {
       std::println("Unable to create the Vulkan Renderer! An error occured: {}", exc.what());
@@ -30,26 +78,28 @@ public:
   }
 
   [[nodiscard]] vis::app::AppResult process_event(const vis::win::Event& event) noexcept {
-    return test_scene.process_event(event);
+    return pong_scene.process_event(event);
   }
 
   [[nodiscard]] vis::app::AppResult update() noexcept {
-    return test_scene.update();
+    return pong_scene.update();
   }
 
 private:
-  App(std::string_view title, int width, int height)
-      : window{title, width, height, screen_flags}, renderer{&window}, test_scene{renderer} {
+  App(std::string_view title, int width, int height, std::optional<std::filesystem::path> recording_path)
+      : renderer{[&] { return &window.emplace(title, width, height, screen_flags); }},
+        pong_scene{renderer, std::move(recording_path)} {
     renderer.set_viewport(0, 0, width, height);
     std::println("{}", renderer.show_info());
   }
 
 private:
-  vis::Window window;
+  // created by the renderer while it starts the Vulkan instance in the background
+  std::optional<vis::Window> window;
   vis::vulkan::Renderer renderer;
   static constexpr vis::WindowsFlags screen_flags = vis::WindowsFlags::vulkan;
 
-  TestScene test_scene;
+  PongScene pong_scene;
 };
 
 } // namespace Game
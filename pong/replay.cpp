@@ -0,0 +1,51 @@
+module;
+
+export module game:replay;
+
+import :simulation;
+
+import std;
+import vis;
+
+export namespace Game {
+
+struct ReplayResult {
+	std::uint64_t ticks = 0;
+	int games_won = 0;
+	int games_lost = 0;
+	vis::chrono::milliseconds elapsed{};
+};
+
+// Runs a recorded match headless, tick after tick with no frame pacing, so it doubles as a repeatable workload for
+// profiling the simulation and as a regression check: the same recording must end with the same score. Built with
+// WITH_ALLOCATION_TRACKING, it also throws on the first tick past the warm up that allocates from the heap.
+ReplayResult replay_match(const std::filesystem::path& path) {
+	auto replay = vis::replay::InputReplay::load(path);
+
+	const auto start = std::chrono::steady_clock::now();
+	PongSimulation simulation{static_cast<std::uint32_t>(replay.seed())};
+	vis::memory::ZeroAllocationCheck allocation_check;
+	for (std::uint64_t tick = 0; tick != replay.tick_count(); ++tick) {
+		vis::memory::AllocationScope allocation_scope{vis::memory::AllocationTag::game};
+		allocation_check.begin_frame();
+		while (const auto event = replay.next(tick)) {
+			const auto accepted = event->pressed ? simulation.key_down(event->key) : simulation.key_up(event->key);
+			if (not accepted)
+				throw std::runtime_error{std::format("Tick {} holds more key events than a tick can take", tick)};
+		}
+		simulation.tick();
+
+		if (const auto allocations = allocation_check.end_frame())
+			throw std::runtime_error{
+					std::format("Tick {} allocated from the heap: {}", tick, vis::memory::describe_allocations(*allocations))};
+	}
+
+	return ReplayResult{
+			.ticks = simulation.tick_count(),
+			.games_won = simulation.games_won(),
+			.games_lost = simulation.games_lost(),
+			.elapsed = std::chrono::steady_clock::now() - start,
+	};
+}
+
+} // namespace Game
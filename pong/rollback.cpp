@@ -0,0 +1,107 @@
+module;
+
+export module game:rollback;
+
+import :simulation;
+
+import std;
+import vis;
+
+export namespace Game {
+
+// One peer of an online match: a PongSimulation where the left pad is a player, seen from the side this peer controls
+class RollbackPong {
+public:
+	using Input = PadInput;
+	using State = PongSimulation::State;
+
+	RollbackPong(std::uint32_t seed, Side local_side) : simulation{seed, Opponent::player}, local_side{local_side} {}
+
+	void save(State& state) const {
+		simulation.save(state);
+	}
+
+	void load(const State& state) {
+		simulation.load(state);
+	}
+
+	[[nodiscard]] std::uint64_t checksum(const State& state) const noexcept {
+		return PongSimulation::checksum(state);
+	}
+
+	// The world is rebuilt first, so the tick depends on the state it starts from and not on whether that state was
+	// reached by simulating or by a rollback
+	void tick(PadInput local, PadInput remote) {
+		simulation.rebuild_world();
+		simulation.set_input(local_side, local);
+		simulation.set_input(local_side == Side::right ? Side::left : Side::right, remote);
+		simulation.tick();
+	}
+
+	[[nodiscard]] const PongSimulation& game() const noexcept {
+		return simulation;
+	}
+
+	// Chases the ball, the stand-in for a keyboard in headless matches
+	[[nodiscard]] PadInput follow_ball() const {
+		constexpr auto dead_zone = 0.05f;
+		const auto offset = simulation.ball_position().y - simulation.pad_position(local_side).y;
+		if (std::abs(offset) < dead_zone)
+			return PadInput::none;
+
+		return offset > 0.0f ? PadInput::up : PadInput::down;
+	}
+
+private:
+	PongSimulation simulation;
+	Side local_side;
+};
+
+struct LoopbackMatchResult {
+	vis::net::RollbackSession<RollbackPong>::Stats right;
+	vis::net::RollbackSession<RollbackPong>::Stats left;
+	// both peers confirmed every tick
+	bool completed = false;
+	// both peers ended with the same ball and score, and no checksum exchanged during the match differed
+	bool in_sync = false;
+};
+
+// Plays a match between two bots, each on its own peer, over a loopback link with the given conditions. Time is
+// simulated, one tick per loop, so the match runs as fast as the rollbacks allow.
+LoopbackMatchResult run_loopback_match(const vis::net::LinkConditions& conditions, std::uint64_t ticks,
+																			 std::uint32_t seed) {
+	using clock = vis::net::LoopbackNetwork::clock;
+	auto now = clock::time_point{};
+	vis::net::LoopbackNetwork network{conditions, [&now] { return now; }, seed};
+
+	RollbackPong right{seed, Side::right};
+	RollbackPong left{seed, Side::left};
+	vis::net::RollbackSession right_session{right, network.endpoint(0)};
+	vis::net::RollbackSession left_session{left, network.endpoint(1)};
+
+	const auto is_final = [ticks](const auto& session) { return session.confirmed_tick() >= ticks; };
+	// a link that drops everything never confirms anything
+	const auto max_loops = 4 * ticks + 1000;
+	for (std::uint64_t loop = 0; loop != max_loops and not(is_final(right_session) and is_final(left_session)); ++loop) {
+		now += std::chrono::duration_cast<clock::duration>(PongSimulation::tick_duration);
+		for (auto [game, session] : {std::pair{&right, &right_session}, std::pair{&left, &left_session}}) {
+			if (session->tick() < ticks)
+				session->advance(game->follow_ball());
+			else
+				session->idle();
+		}
+	}
+
+	const auto& right_game = right.game();
+	const auto& left_game = left.game();
+	return LoopbackMatchResult{
+			.right = right_session.statistics(),
+			.left = left_session.statistics(),
+			.completed = is_final(right_session) and is_final(left_session),
+			.in_sync = right_session.statistics().desyncs == 0 and left_session.statistics().desyncs == 0 and
+								 right_game.ball_position() == left_game.ball_position() and
+								 right_game.games_won() == left_game.games_won() and right_game.games_lost() == left_game.games_lost(),
+	};
+}
+
+} // namespace Game
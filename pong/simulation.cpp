@@ -0,0 +1,625 @@
+module;
+
+export module game:simulation;
+
+import :events;
+import :components;
+import :constants;
+import :trajectory;
+
+import std;
+import vis;
+
+export namespace Game {
+using namespace vis::literals::chrono_literals;
+
+// Who moves the left pad
+enum class Opponent : bool { computer, player };
+
+enum class Side : bool { left, right };
+
+// Whether the simulation prints what happens, the benchmarks keep it quiet to time the game and not the terminal
+enum class Logging : bool { quiet, verbose };
+
+// What a pad does during one tick
+enum class PadInput : std::uint8_t { none, up, down };
+
+// The game without its window: registry, physics and rules, advanced one fixed tick at a time. Given the same seed
+// and the same input at the same ticks it plays the same match, so PongScene drives it in real time and the replay
+// driver as fast as it can.
+class PongSimulation {
+public:
+	static constexpr vis::chrono::seconds tick_duration = 1.0_s / 60.0_s;
+	// Key presses and releases one tick can take, a key repeat of a few per frame leaves plenty of room
+	static constexpr std::size_t max_key_events_per_tick = 64;
+
+	// Everything a tick changes, save() and load() rewind the match to it. The entities and bodies are never destroyed
+	// during a match, a new round moves them back to their kick-off place instead.
+	struct State {
+		vis::physics::WorldSnapshot bodies;
+		std::mt19937 random;
+		BallComponent ball{};
+		InputComponent player_input{};
+		InputComponent opponent_input{};
+		std::uint64_t ticks = 0;
+		bool is_ball_colliding_with_pad = false;
+		int win_games = 0;
+		int lost_games = 0;
+	};
+
+	explicit PongSimulation(std::uint32_t seed, Opponent opponent = Opponent::computer,
+													Logging logging = Logging::verbose)
+			: half_world_extent{vis::orthogonal_matrix(SCREEN_WIDTH, SCREEN_HEIGHT, world_width, world_height)
+															.half_world_extent},
+				opponent{opponent}, logging{logging}, random{seed},
+				trajectory{-pad_contact_x(), pad_contact_x(), ball_radius} {
+		dispatcher.reserve<KeyEvent>(max_key_events_per_tick);
+		dispatcher.sink<KeyEvent>().connect<&PongSimulation::on_key>(this);
+
+		initialize_game();
+	}
+
+	PongSimulation(const PongSimulation&) = delete;
+	PongSimulation& operator=(const PongSimulation&) = delete;
+
+	// Input takes effect on the next tick. Any thread can call them, the events are delivered in order when the tick
+	// starts. Returns false, and drops the key, when the tick already holds max_key_events_per_tick of them: only the
+	// accepted ones belong in a recording.
+	[[nodiscard]] bool key_down(vis::win::VirtualKey key) {
+		return dispatcher.enqueue(KeyEvent{key, true});
+	}
+
+	[[nodiscard]] bool key_up(vis::win::VirtualKey key) {
+		return dispatcher.enqueue(KeyEvent{key, false});
+	}
+
+	// Moves a pad during the next tick, the left one only when the opponent is a player
+	void set_input(Side side, PadInput input) {
+		constexpr auto directions = std::array{vis::vec2{}, up, down};
+		const auto pad = side == Side::right ? player_entity : opponent_entity;
+		entity_registry.get<InputComponent>(pad).direction = directions[std::to_underlying(input)];
+	}
+
+	void save(State& state) const {
+		world.snapshot(entity_registry, state.bodies);
+		state.random = random;
+		state.ball = entity_registry.get<BallComponent>(ball_entity);
+		state.player_input = entity_registry.get<InputComponent>(player_entity);
+		if (const auto* input = entity_registry.try_get<InputComponent>(opponent_entity))
+			state.opponent_input = *input;
+		state.ticks = ticks;
+		state.is_ball_colliding_with_pad = is_ball_colliding_with_pad;
+		state.win_games = win_games;
+		state.lost_games = lost_games;
+	}
+
+	void load(const State& state) {
+		world.restore(entity_registry, state.bodies);
+		random = state.random;
+		entity_registry.get<BallComponent>(ball_entity) = state.ball;
+		entity_registry.get<InputComponent>(player_entity) = state.player_input;
+		if (auto* input = entity_registry.try_get<InputComponent>(opponent_entity))
+			*input = state.opponent_input;
+		ticks = state.ticks;
+		is_ball_colliding_with_pad = state.is_ball_colliding_with_pad;
+		win_games = state.win_games;
+		lost_games = state.lost_games;
+		trajectory.invalidate();
+	}
+
+	void tick() {
+		frame_memory.next_frame();
+		dispatcher.update();
+		update_physic_system();
+		update_ai_system(tick_duration);
+		update_input_system(tick_duration);
+		update_ball_system();
+		update_game_logic();
+		++ticks;
+
+		if (not is_playing) {
+			log("You {}!", win ? "win" : "lose");
+			log("Player {} - Computer {}", win_games, lost_games);
+			reset_round();
+			is_playing = true;
+		}
+	}
+
+	// Starts the next round. Everything moves back to the kick-off instead of the scene being built again: the world,
+	// the bodies, their shapes and the registry storages are kept, so a restart does not allocate and a rollback can
+	// cross rounds.
+	void reset_round() {
+		world.restore(entity_registry, kickoff);
+		for (auto [entity, input] : entity_registry.view<InputComponent>().each())
+			input = InputComponent{};
+		entity_registry.get<BallComponent>(ball_entity) = BallComponent{};
+		is_ball_colliding_with_pad = false;
+		launch_ball();
+	}
+
+	// Builds the physics world again, every body created anew in the same order and put back where it is now. Box2D
+	// keeps contacts, their warm starting and sensor overlaps out of any snapshot, and they steer the next steps: a
+	// simulation rebuilt before each tick goes on from its State alone, so a rollback simulates the same ticks again bit
+	// for bit. A contact going on across the rebuild begins again, is_ball_colliding_with_pad ignores that one.
+	void rebuild_world() {
+		world.snapshot(entity_registry, rebuilt_bodies);
+		entity_registry.clear<vis::physics::RigidBody>();
+		initialize_physics();
+		for (const auto& blueprint : blueprints)
+			build_body(blueprint);
+		world.restore(entity_registry, rebuilt_bodies);
+		// the cached path depends on when it was computed, not on the state
+		trajectory.invalidate();
+	}
+
+	// FNV-1a of everything a State holds but the random engine, whose draws only diverge along with the bodies. Two
+	// peers with the same checksum for a tick are in sync on it.
+	[[nodiscard]] static std::uint64_t checksum(const State& state) noexcept {
+		auto hash = 0xcbf29ce484222325ull;
+		const auto mix = [&hash]<typename Value>(const Value& value) {
+			for (const auto byte : std::as_bytes(std::span{&value, 1}))
+				hash = (hash ^ std::to_integer<std::uint64_t>(byte)) * 0x100000001b3ull;
+		};
+		for (const auto& body : state.bodies.bodies()) {
+			mix(body.entity);
+			mix(body.position);
+			mix(body.rotation);
+			mix(body.linear_velocity);
+			mix(body.angular_velocity);
+			mix(body.awake);
+			mix(body.enabled);
+		}
+		mix(state.ball.position);
+		mix(state.ball.velocity);
+		mix(state.player_input.direction);
+		mix(state.opponent_input.direction);
+		mix(state.ticks);
+		mix(state.is_ball_colliding_with_pad);
+		mix(state.win_games);
+		mix(state.lost_games);
+		return hash;
+	}
+
+	[[nodiscard]] const vis::ecs::registry& registry() const noexcept {
+		return entity_registry;
+	}
+
+	[[nodiscard]] std::uint64_t tick_count() const noexcept {
+		return ticks;
+	}
+
+	[[nodiscard]] int games_won() const noexcept {
+		return win_games;
+	}
+
+	[[nodiscard]] int games_lost() const noexcept {
+		return lost_games;
+	}
+
+	[[nodiscard]] vis::vec2 pad_position(Side side) const {
+		const auto pad = side == Side::right ? player_entity : opponent_entity;
+		return entity_registry.get<vis::physics::RigidBody>(pad).get_transform().position;
+	}
+
+	[[nodiscard]] vis::vec2 ball_position() const {
+		return entity_registry.get<vis::physics::RigidBody>(ball_entity).get_transform().position;
+	}
+
+	[[nodiscard]] const TrajectoryPredictor& ball_trajectory() const noexcept {
+		return trajectory;
+	}
+
+private:
+	enum class IsPlayer : bool { yes = true, no = false };
+
+	using BodyGeometry = std::variant<vis::physics::Polygon, vis::physics::Circle>;
+
+	struct BodyBlueprint {
+		vis::ecs::entity entity;
+		vis::physics::RigidBodyDef body;
+		vis::physics::ShapeDef shape;
+		BodyGeometry geometry;
+	};
+
+	// The line is formatted in the memory of the tick, logging does not allocate from the heap
+	template <typename... Args> void log(std::format_string<Args...> format, Args&&... args) {
+		if (logging == Logging::verbose)
+			vis::memory::println(frame_memory.resource(), format, std::forward<Args>(args)...);
+	}
+
+	void initialize_game() {
+		initialize_physics();
+		initialize_scene();
+		world.snapshot(entity_registry, kickoff);
+		launch_ball();
+	}
+
+	void launch_ball() {
+		const auto vel_mag = vis::get_random(random, ball_vel_min_speed, ball_vel_max_speed);
+		const auto direction = vis::get_random_direction(random, vis::vec2{-1.0f, 0.0f}, ball_angle_min, ball_angle_max);
+		entity_registry.get<vis::physics::RigidBody>(ball_entity).set_linear_velocity(direction * vel_mag);
+		trajectory.invalidate();
+	}
+
+	void update_input_system(vis::chrono::seconds dt) {
+		entity_registry
+				.view<PlayerSpeed, InputComponent, vis::physics::RigidBody>() //
+				.each([&](const PlayerSpeed player_component, const InputComponent& input, vis::physics::RigidBody& rb) {
+					auto transform = rb.get_transform();
+					auto& pos = transform.position;
+
+					pos += input.direction * dt * player_component.speed;
+					pos.y = std::clamp(pos.y, -max_upper_bound(), max_upper_bound());
+
+					rb.set_transform(transform);
+				});
+	}
+
+	void update_ai_system(vis::chrono::seconds dt) {
+		const auto& ball_rb = entity_registry.get<vis::physics::RigidBody>(ball_entity);
+		trajectory.update(world, ball_rb.get_transform().position, ball_rb.get_linear_velocity());
+		const BallComponent& ball = entity_registry.get<BallComponent>(ball_entity);
+
+		entity_registry
+				.view<AiComponent, vis::physics::RigidBody>() //
+				.each([&](AiComponent ai, vis::physics::RigidBody& ai_pad_rb) {
+					auto pad_transform = ai_pad_rb.get_transform();
+					auto& pad_pos = pad_transform.position;
+
+					// where the ball meets the pad line when it heads this way, the ball itself otherwise
+					const auto intercept = pad_pos.x < 0.0f ? trajectory.left_intercept() : trajectory.right_intercept();
+					const auto target_y = intercept ? intercept->y : ball.position.y;
+
+					const auto y_pad_ball_distance = pad_pos.y - target_y;
+					const auto direction = (target_y > pad_pos.y) ? up : down;
+
+					pad_pos += direction * dt * ai.speed;
+
+					auto new_y_pad_ball_distance = pad_pos.y - target_y;
+
+					if (std::signbit(new_y_pad_ball_distance) != std::signbit(y_pad_ball_distance)) {
+						// clamp the y
+						pad_pos.y = target_y; // avoid to run too fast
+					}
+
+					pad_pos.y = std::clamp(pad_pos.y, -max_upper_bound(), max_upper_bound());
+					ai_pad_rb.set_transform(pad_transform);
+				});
+	}
+
+	void update_physic_system() {
+		world.step(tick_duration, 4);
+	}
+
+	void update_ball_system() {
+		auto contacts = world.get_contact_events(frame_memory.resource());
+
+		for (auto it = contacts.begin_end_touch(); //
+				 it != contacts.end_end_touch();			 //
+				 ++it) {
+			auto is_ball = ball_entity == it->get_entity_a() || ball_entity == it->get_entity_b();
+			bool is_ai_or_player = opponent_entity == it->get_entity_a() || opponent_entity == it->get_entity_b() ||
+														 player_entity == it->get_entity_a() || player_entity == it->get_entity_b();
+
+			if (is_ball && is_ai_or_player) {
+				log("[{}] ball stopped collision", ticks);
+				is_ball_colliding_with_pad = false;
+			}
+		}
+
+		for (auto it = contacts.begin_begin_touch(); //
+				 it != contacts.end_begin_touch();			 //
+				 ++it) {
+			// a bounce, the ball leaves on a new line
+			if (ball_entity == it->get_entity_a() || ball_entity == it->get_entity_b())
+				trajectory.invalidate();
+
+			if (is_ball_colliding_with_pad) {
+				log("[{}] ball already in collision - exiting", ticks);
+				return;
+			}
+
+			auto is_ball = ball_entity == it->get_entity_a() || ball_entity == it->get_entity_b();
+			bool is_ai_or_player = opponent_entity == it->get_entity_a() || opponent_entity == it->get_entity_b() ||
+														 player_entity == it->get_entity_a() || player_entity == it->get_entity_b();
+
+			if (is_ball && is_ai_or_player) {
+				log("[{}] start ball collision", ticks);
+				is_ball_colliding_with_pad = true;
+			}
+
+			if (is_ai_or_player) {
+				vis::physics::RigidBody& ball_rb = entity_registry.get<vis::physics::RigidBody>(ball_entity);
+
+				auto ball_dir = vis::normalize(ball_rb.get_linear_velocity());
+				auto force_direction = vis::get_random_direction(random, ball_dir, ball_angle_min, ball_angle_max);
+				auto force_mag = vis::get_random(random, ball_vel_min_speed, ball_vel_max_speed);
+				auto impulse = force_direction * force_mag;
+
+				// ball_rb.apply_linear_impulse_to_center(impulse);
+				log("[{}] ball direction: {}, new force: {} (mag: {})", ticks, ball_dir, impulse, force_mag);
+			}
+
+			log("[{}] There was a start of collision between {} and {}", ticks, static_cast<int>(it->get_entity_a()),
+					static_cast<int>(it->get_entity_b()));
+		}
+
+		entity_registry.view<vis::physics::RigidBody, BallComponent>().each(
+				[&](vis::physics::RigidBody& rb, BallComponent& ball) {
+					ball.position = rb.get_transform().position;
+					ball.velocity = rb.get_linear_velocity();
+				});
+	}
+
+	void update_game_logic() {
+		auto sensor_events = world.get_sensor_events(frame_memory.resource());
+		for (auto begin_touch_it = sensor_events.begin_begin_touch(); //
+				 begin_touch_it != sensor_events.end_begin_touch();				//
+				 ++begin_touch_it) {
+			is_playing = false;
+
+			auto sensor_entity = begin_touch_it->get_sensor_entity();
+
+			win = sensor_entity == ai_sensor;
+			win_games += win;
+			lost_games += !win;
+		}
+	}
+
+	void initialize_physics() {
+		auto world_def = vis::physics::WorldDef();
+		world_def.set_gravity(vis::vec2{0.0f, 0.0f * -9.81f});
+		world = vis::physics::create_world(world_def);
+	}
+
+	void initialize_scene() {
+		const auto left_pos = vis::vec2{-half_world_extent.x, 0.0f} + x_offset;
+		const auto right_pos = vis::vec2{+half_world_extent.x, 0.0f} - x_offset;
+		const auto top_pos = vis::vec2{0.0f, +half_world_extent.y} - y_offset;
+		const auto bottom_pos = vis::vec2{0.0f, -half_world_extent.y} + y_offset;
+
+		const auto vertical_half_extent = vis::vec2{half_world_extent.x, half_wall_thickness};
+		const auto horizontal_half_extent = vis::vec2{half_wall_thickness, half_world_extent.y};
+
+		add_pad(half_pad_extent, left_pos, colors::white);
+		add_player(half_pad_extent, right_pos, colors::white);
+		add_ball(ball_radius, origin, colors::white);
+		add_wall(vertical_half_extent, top_pos, colors::white);
+		add_wall(vertical_half_extent, bottom_pos, colors::white);
+
+		add_goal(horizontal_half_extent, left_pos - vis::vec2{wall_thickness + offset_magnitude, 0.0f}, colors::black,
+						 IsPlayer::no);
+		add_goal(horizontal_half_extent, right_pos + vis::vec2{wall_thickness + offset_magnitude, 0.0f}, colors::black,
+						 IsPlayer::yes);
+	}
+
+	void on_key(const KeyEvent& event) {
+		if (event.pressed)
+			on_key_down(event.key);
+		else
+			on_key_up(event.key);
+	}
+
+	void on_key_down(vis::win::VirtualKey key) {
+		auto& input_component = entity_registry.get<InputComponent>(player_entity);
+
+		switch (key) {
+		case vis::win::VirtualKey::down:
+		case vis::win::VirtualKey::right:
+			input_component.direction = down;
+			break;
+
+		case vis::win::VirtualKey::up:
+		case vis::win::VirtualKey::left:
+			input_component.direction = up;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void on_key_up(vis::win::VirtualKey key) {
+		auto& input_component = entity_registry.get<InputComponent>(player_entity);
+		switch (key) {
+		case vis::win::VirtualKey::down:
+		case vis::win::VirtualKey::up:
+		case vis::win::VirtualKey::right:
+		case vis::win::VirtualKey::left:
+			input_component.direction = vis::vec2{};
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void add_player(vis::vec2 half_extent, vis::vec2 pos, vis::vec4 color) {
+		player_entity = entity_registry.create();
+		entity_registry.emplace<PlayerSpeed>(player_entity, PlayerSpeed{.speed = initial_player_speed});
+		entity_registry.emplace<InputComponent>(player_entity, InputComponent{});
+		entity_registry.emplace<RectangleShape>(player_entity, half_extent, color);
+
+		auto body_def = vis::physics::RigidBodyDef{} //
+												.set_position(pos)			 //
+												.set_body_type(vis::physics::BodyType::kinematic);
+		auto wall_shape = vis::physics::ShapeDef{} //
+													.set_restitution(1.0f)
+													.enable_contact_events(true)
+													.set_friction(friction);
+		add_body(player_entity, body_def, wall_shape, vis::physics::create_box2d(half_extent));
+
+		log("Creating player pad with id: {}", static_cast<int>(player_entity));
+	}
+
+	void add_pad(vis::vec2 half_extent, vis::vec2 pos, vis::vec4 color) {
+		opponent_entity = entity_registry.create();
+		if (opponent == Opponent::computer) {
+			entity_registry.emplace<AiComponent>(opponent_entity, AiComponent{.speed = initial_ai_speed});
+		} else {
+			entity_registry.emplace<PlayerSpeed>(opponent_entity, PlayerSpeed{.speed = initial_player_speed});
+			entity_registry.emplace<InputComponent>(opponent_entity, InputComponent{});
+		}
+		entity_registry.emplace<RectangleShape>(opponent_entity, half_extent, color);
+
+		auto body_def = vis::physics::RigidBodyDef{}
+												.set_position(pos) //
+												.set_body_type(vis::physics::BodyType::kinematic);
+
+		auto shape = vis::physics::ShapeDef{} //
+										 .set_restitution(1.0f)
+										 .set_friction(friction)
+										 .enable_contact_events(true);
+		add_body(opponent_entity, body_def, shape, vis::physics::create_box2d(half_extent));
+
+		log("Creating opponent pad with id: {}", static_cast<int>(opponent_entity));
+	}
+
+	// The ball rests until launch_ball()
+	void add_ball(float radius, vis::vec2 pos, vis::vec4 color) {
+		ball_entity = entity_registry.create();
+		entity_registry.emplace<BallComponent>(ball_entity);
+
+		entity_registry.emplace<CircleShape>(ball_entity, radius, color);
+
+		auto circle = vis::physics::Circle{
+				.center = {},
+				.radius = radius,
+		};
+
+		auto body_def = vis::physics::RigidBodyDef{} //
+												.set_position(pos)
+												.set_body_type(vis::physics::BodyType::dynamic)
+												.set_fixed_rotation(false)
+												.set_is_bullet(true);
+
+		auto shape_def = vis::physics::ShapeDef{} //
+												 .set_restitution(1.0)
+												 .set_friction(friction)
+												 .enable_hit_events(true)
+												 .enable_contact_events(true);
+		add_body(ball_entity, body_def, shape_def, circle);
+
+		log("Creating ball with id: {}", static_cast<int>(ball_entity));
+	}
+
+	void add_wall(vis::vec2 half_extent, vis::vec2 pos, vis::vec4 color) {
+		auto wall = entity_registry.create();
+
+		entity_registry.emplace<RectangleShape>(wall, half_extent, color);
+
+		auto body_def = vis::physics::RigidBodyDef{}
+												.set_position(pos) //
+												.set_body_type(vis::physics::BodyType::fixed);
+
+		auto wall_shape = vis::physics::ShapeDef{} //
+													.set_restitution(1.0f)
+													.set_friction(friction)
+													.enable_contact_events(true);
+		add_body(wall, body_def, wall_shape, vis::physics::create_box2d(half_extent));
+		trajectory.add_wall(wall);
+
+		log("Creating wall with id: {}", static_cast<int>(wall));
+	}
+
+	void add_goal(vis::vec2 half_extent, vis::vec2 pos, vis::vec4 color, IsPlayer is_player) {
+		auto& entity = is_player == IsPlayer::yes ? player_sensor : ai_sensor;
+		entity = entity_registry.create();
+
+		entity_registry.emplace<RectangleShape>(entity, half_extent, color);
+		auto body_def = vis::physics::RigidBodyDef{}
+												.set_position(pos) //
+												.set_body_type(vis::physics::BodyType::fixed);
+		auto wall_shape = vis::physics::ShapeDef{} //
+													.set_is_sensor(true);
+		add_body(entity, body_def, wall_shape, vis::physics::create_box2d(half_extent));
+	}
+
+	// Creates the body of the entity and keeps how, so rebuild_world() can create it again the same way
+	void add_body(vis::ecs::entity entity, const vis::physics::RigidBodyDef& body, const vis::physics::ShapeDef& shape,
+								const BodyGeometry& geometry) {
+		blueprints.push_back(BodyBlueprint{.entity = entity, .body = body, .shape = shape, .geometry = geometry});
+		build_body(blueprints.back());
+	}
+
+	void build_body(const BodyBlueprint& blueprint) {
+		auto& rigid_body = entity_registry.emplace<vis::physics::RigidBody>(
+				blueprint.entity, world.create_body(blueprint.body, blueprint.entity));
+		std::visit([&](const auto& geometry) { rigid_body.create_shape(blueprint.shape, geometry); }, blueprint.geometry);
+	}
+
+	[[nodiscard]] float max_upper_bound() const {
+		return half_world_extent.y - 2 * half_wall_thickness - pad_length / 2.0f;
+	}
+
+	// x of the ball center touching the face of the right pad, the left one is mirrored
+	[[nodiscard]] float pad_contact_x() const {
+		return half_world_extent.x - x_offset.x - half_pad_thickness - ball_radius;
+	}
+
+private:
+	// the arena of the initial window size, resizing the window does not change the match
+	vis::vec2 half_world_extent;
+	Opponent opponent;
+	Logging logging;
+	std::mt19937 random;
+
+	// before the registry, so the rigid bodies are destroyed while their world still exists
+	vis::physics::World world;
+	vis::ecs::registry entity_registry;
+	vis::ecs::ConcurrentDispatcher dispatcher;
+	vis::physics::WorldSnapshot kickoff;
+	// every body in creation order, and the capture rebuild_world() reuses
+	std::vector<BodyBlueprint> blueprints;
+	vis::physics::WorldSnapshot rebuilt_bodies;
+	// the events and log lines of one tick
+	vis::memory::FrameAllocator frame_memory;
+	TrajectoryPredictor trajectory;
+
+	std::uint64_t ticks = 0;
+
+	bool is_playing = true;
+	bool win = false;
+	bool is_ball_colliding_with_pad = false;
+	vis::ecs::entity ai_sensor;
+	vis::ecs::entity player_sensor;
+	vis::ecs::entity ball_entity;
+	vis::ecs::entity player_entity;
+	vis::ecs::entity opponent_entity;
+
+	int win_games = 0;
+	int lost_games = 0;
+};
+
+struct RestartBenchmark {
+	// building the match from scratch, what every round did before reset_round()
+	vis::chrono::microseconds rebuild;
+	vis::chrono::microseconds reset;
+};
+
+// Average cost of the two ways to restart a match. The rebuild creates the world, every body and shape and fills a
+// new registry; the reset moves the existing bodies back in place. Both run quiet, the terminal is not timed.
+RestartBenchmark benchmark_restart(int repetitions = 100) {
+	if (repetitions <= 0)
+		throw std::invalid_argument{std::format("Cannot average over {} repetitions", repetitions)};
+
+	const auto count = static_cast<float>(repetitions);
+	std::optional<PongSimulation> simulation;
+
+	const auto rebuild_start = std::chrono::steady_clock::now();
+	for (auto i = 0; i != repetitions; ++i) {
+		simulation.reset();
+		simulation.emplace(static_cast<std::uint32_t>(i), Opponent::computer, Logging::quiet);
+	}
+	const auto reset_start = std::chrono::steady_clock::now();
+	for (auto i = 0; i != repetitions; ++i)
+		simulation->reset_round();
+	const auto reset_end = std::chrono::steady_clock::now();
+
+	return RestartBenchmark{
+			.rebuild = vis::chrono::microseconds{reset_start - rebuild_start} / count,
+			.reset = vis::chrono::microseconds{reset_end - reset_start} / count,
+	};
+}
+
+} // namespace Game
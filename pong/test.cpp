@@ -48,6 +48,8 @@ export {
 
     [[nodiscard]] vis::app::AppResult update() noexcept override {
       renderer.render();
+      // throttle here, before SDL delivers the next events, so the next frame works on the freshest input
+      renderer.wait_for_next_frame();
       return vis::app::AppResult::app_continue;
     }
 
@@ -0,0 +1,106 @@
+module;
+
+export module game:trajectory;
+
+import std;
+import vis;
+
+export namespace Game {
+
+// Where the ball is going: its path from the last prediction up to the line of the pad it is heading to, bouncing off
+// the walls, found with circle casts of the ball through the physics world. The ball travels in straight lines between
+// two contacts, so the path stays valid until the next contact changes its velocity: invalidate() on those, update()
+// every tick, and any number of controllers read the intercepts for free in between.
+class TrajectoryPredictor {
+public:
+	static constexpr std::size_t max_bounces = 8;
+
+	// left_x and right_x are where the center of the ball is when it touches the face of each pad
+	TrajectoryPredictor(float left_x, float right_x, float ball_radius)
+			: left_x{left_x}, right_x{right_x}, ball_radius{ball_radius} {}
+
+	// The shapes the ball bounces off, anything else the casts go through
+	void add_wall(vis::ecs::entity wall) {
+		walls.push_back(wall);
+	}
+
+	void invalidate() noexcept {
+		is_dirty = true;
+	}
+
+	// Recomputes the path from the ball state when invalidated since the last update, does nothing otherwise
+	void update(const vis::physics::World& world, vis::vec2 position, vis::vec2 velocity) {
+		if (not is_dirty)
+			return;
+
+		is_dirty = false;
+		left = std::nullopt;
+		right = std::nullopt;
+		path_size = 0;
+		path_points[path_size++] = position;
+
+		for (auto bounce = 0uz; bounce <= max_bounces and velocity.x != 0.0f; ++bounce) {
+			const auto target_x = velocity.x < 0.0f ? left_x : right_x;
+			const auto time_to_target = (target_x - position.x) / velocity.x;
+			if (time_to_target < 0.0f)
+				break;
+
+			const auto end = position + velocity * time_to_target;
+			const auto cast = vis::physics::CircleCastQuery{.start = position, .end = end, .radius = ball_radius};
+			world.cast_circles(std::span{&cast, 1}, vis::physics::QueryMode::all, results);
+
+			const auto hits = results[0];
+			const auto wall_hit = std::ranges::find_if(hits, [this](const vis::physics::QueryHit& hit) {
+				return std::ranges::find(walls, hit.entity) != walls.end();
+			});
+			if (wall_hit == hits.end()) {
+				path_points[path_size++] = end;
+				(velocity.x < 0.0f ? left : right) = end;
+				break;
+			}
+
+			// the center of the ball at the contact, moved off the wall so the next cast does not start touching it
+			position = position + (end - position) * wall_hit->fraction + wall_hit->normal * contact_offset;
+			velocity = vis::reflect(velocity, wall_hit->normal);
+			path_points[path_size++] = position;
+		}
+		++recomputations;
+	}
+
+	// Center of the ball when it reaches the pad line, if it heads that way within max_bounces
+	[[nodiscard]] std::optional<vis::vec2> left_intercept() const noexcept {
+		return left;
+	}
+
+	[[nodiscard]] std::optional<vis::vec2> right_intercept() const noexcept {
+		return right;
+	}
+
+	// From the ball at the last recomputation to the intercept, one point per bounce in between
+	[[nodiscard]] std::span<const vis::vec2> path() const noexcept {
+		return std::span{path_points}.first(path_size);
+	}
+
+	[[nodiscard]] std::uint64_t recomputation_count() const noexcept {
+		return recomputations;
+	}
+
+private:
+	static constexpr float contact_offset = 1e-3f;
+
+	float left_x;
+	float right_x;
+	float ball_radius;
+	std::vector<vis::ecs::entity> walls;
+
+	bool is_dirty = true;
+	std::optional<vis::vec2> left;
+	std::optional<vis::vec2> right;
+	std::array<vis::vec2, max_bounces + 2> path_points{};
+	std::size_t path_size = 0;
+	// reused by every cast, it stops allocating after the first recomputation
+	vis::physics::QueryResults results;
+	std::uint64_t recomputations = 0;
+};
+
+} // namespace Game
@@ -0,0 +1,18 @@
+#version 460
+
+// the quad spans [-1, 1] in local_position, the circle is the unit disk inside it
+layout(location = 0) in vec2 local_position;
+layout(location = 1) in vec4 vertex_color;
+
+layout(location = 0) out vec4 fragment_color;
+
+void main() {
+    const float signed_distance = length(local_position) - 1.0;
+    const float edge_width = fwidth(signed_distance);
+    const float coverage = 1.0 - smoothstep(-edge_width, edge_width, signed_distance);
+
+    if (coverage <= 0.0)
+        discard;
+
+    fragment_color = vec4(vertex_color.rgb, vertex_color.a * coverage);
+}
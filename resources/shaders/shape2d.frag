@@ -0,0 +1,10 @@
+#version 460
+
+layout(location = 0) in vec2 local_position;
+layout(location = 1) in vec4 vertex_color;
+
+layout(location = 0) out vec4 fragment_color;
+
+void main() {
+    fragment_color = vertex_color;
+}
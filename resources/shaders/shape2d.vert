@@ -0,0 +1,36 @@
+#version 460
+
+// one instance per shape, the quad corners come from gl_VertexIndex. The columns of the model transform map the
+// [-1, 1] quad to the world, its half extent and rotation included.
+layout(location = 0) in vec2 x_axis;
+layout(location = 1) in vec2 y_axis;
+layout(location = 2) in vec2 translation;
+layout(location = 3) in vec4 color;
+
+layout(push_constant) uniform PushConstants {
+    mat3x2 view_projection;
+} push_constants;
+
+layout(location = 0) out vec2 local_position;
+layout(location = 1) out vec4 vertex_color;
+
+const vec2 corners[6] = vec2[](
+    vec2(-1.0, -1.0),
+    vec2(1.0, -1.0),
+    vec2(1.0, 1.0),
+    vec2(-1.0, -1.0),
+    vec2(1.0, 1.0),
+    vec2(-1.0, 1.0)
+);
+
+void main() {
+    const vec2 corner = corners[gl_VertexIndex];
+    const vec2 world = x_axis * corner.x + y_axis * corner.y + translation;
+
+    gl_Position = vec4(push_constants.view_projection * vec3(world, 1.0), 0.0, 1.0);
+    // the projection follows the OpenGL convention, in Vulkan clip space y points down
+    gl_Position.y = -gl_Position.y;
+
+    local_position = corner;
+    vertex_color = color;
+}
@@ -23,15 +23,18 @@ inline vis::app::AppResult from_sdl(SDL_AppResult app_result) {
 }
 
 vis::win::Event from_sdl(SDL_Event& event) {
+	const auto timestamp = vis::win::Timestamp{static_cast<vis::win::Timestamp::rep>(event.common.timestamp)};
+
 	switch (event.type) {
 	case SDL_EVENT_QUIT:
-		return vis::win::QuitEvent{};
+		return vis::win::QuitEvent{.timestamp = timestamp};
 
 	case SDL_EVENT_KEY_DOWN:
 		return vis::win::KeyboardKeyDownEvent{
 				.key = static_cast<vis::win::VirtualKey>(event.key.key),
 				.pressed = event.key.down ? vis::win::Pressed::yes : vis::win::Pressed::no,
 				.repeated = event.key.repeat ? vis::win::Repeated::yes : vis::win::Repeated::no,
+				.timestamp = timestamp,
 		};
 		break;
 
@@ -40,13 +43,14 @@ vis::win::Event from_sdl(SDL_Event& event) {
 				.key = static_cast<vis::win::VirtualKey>(event.key.key),
 				.pressed = event.key.down ? vis::win::Pressed::yes : vis::win::Pressed::no,
 				.repeated = event.key.repeat ? vis::win::Repeated::yes : vis::win::Repeated::no,
+				.timestamp = timestamp,
 		};
 
 	case SDL_EVENT_WINDOW_RESIZED:
-		return vis::win::WindowsResized{.width = event.window.data1, .height = event.window.data2};
+		return vis::win::WindowsResized{.width = event.window.data1, .height = event.window.data2, .timestamp = timestamp};
 
 	default:
-		return vis::win::NullEvent{};
+		return vis::win::NullEvent{.timestamp = timestamp};
 	}
 
 	return vis::win::QuitEvent{};
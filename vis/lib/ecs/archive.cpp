@@ -0,0 +1,476 @@
+module;
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+export module vis.ecs.archive;
+
+import std;
+import vis.chrono;
+import vis.ecs;
+
+export namespace vis::ecs {
+
+// Read-only view of a whole file mapped in memory, the OS pages it in on first access
+class MappedFile {
+public:
+	explicit MappedFile(const std::filesystem::path& path) {
+#if defined(_WIN32)
+		const auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+																	FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error{std::format("Unable to open {}", path.string())};
+
+		LARGE_INTEGER file_size{};
+		GetFileSizeEx(file, &file_size);
+		length = static_cast<std::size_t>(file_size.QuadPart);
+
+		// the view keeps the mapping alive, neither handle is needed once it exists
+		if (length != 0) {
+			const auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping != nullptr) {
+				data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				CloseHandle(mapping);
+			}
+		}
+		CloseHandle(file);
+#else
+		const auto file = ::open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			throw std::runtime_error{std::format("Unable to open {}", path.string())};
+
+		struct stat file_stat{};
+		::fstat(file, &file_stat);
+		length = static_cast<std::size_t>(file_stat.st_size);
+
+		// the mapping outlives the descriptor
+		if (length != 0) {
+			auto* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapped != MAP_FAILED) {
+				::madvise(mapped, length, MADV_SEQUENTIAL);
+				data = static_cast<const std::byte*>(mapped);
+			}
+		}
+		::close(file);
+#endif
+
+		if (length != 0 and data == nullptr)
+			throw std::runtime_error{std::format("Unable to map {}", path.string())};
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept
+			: data{std::exchange(other.data, nullptr)}, length{std::exchange(other.length, 0uz)} {}
+
+	MappedFile& operator=(MappedFile&& other) noexcept {
+		std::swap(data, other.data);
+		std::swap(length, other.length);
+		return *this;
+	}
+
+	~MappedFile() {
+		if (data == nullptr)
+			return;
+
+#if defined(_WIN32)
+		UnmapViewOfFile(data);
+#else
+		::munmap(const_cast<std::byte*>(data), length);
+#endif
+	}
+
+	// Page aligned, so every block the snapshot writer aligned stays aligned in memory
+	[[nodiscard]] std::span<const std::byte> bytes() const noexcept {
+		return {data, length};
+	}
+
+private:
+	const std::byte* data = nullptr;
+	std::size_t length = 0;
+};
+
+// Appends trivially copyable values as their raw bytes. It is also an output archive for vis::ecs::snapshot.
+class BinaryOutputArchive {
+public:
+	template <typename Type>
+		requires std::is_trivially_copyable_v<Type>
+	void operator()(const Type& value) {
+		write(std::as_bytes(std::span{&value, 1}));
+	}
+
+	void write(std::span<const std::byte> bytes) {
+		buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+	}
+
+	// Pads with zeros up to the next multiple of alignment
+	void align(std::size_t alignment) {
+		buffer.resize((buffer.size() + alignment - 1) / alignment * alignment);
+	}
+
+	[[nodiscard]] std::span<const std::byte> bytes() const noexcept {
+		return buffer;
+	}
+
+	void save(const std::filesystem::path& path) const {
+		std::ofstream file{path, std::ios::binary | std::ios::trunc};
+		file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+		if (not file)
+			throw std::runtime_error{std::format("Unable to write {}", path.string())};
+	}
+
+private:
+	std::vector<std::byte> buffer;
+};
+
+// Reads what BinaryOutputArchive wrote straight from memory, typically a MappedFile. It is also an input archive for
+// vis::ecs::snapshot_loader and vis::ecs::continuous_loader.
+class BinaryInputArchive {
+public:
+	explicit BinaryInputArchive(std::span<const std::byte> bytes) noexcept : bytes{bytes} {}
+
+	template <typename Type>
+		requires std::is_trivially_copyable_v<Type>
+	void operator()(Type& value) {
+		std::memcpy(&value, read(sizeof(Type)).data(), sizeof(Type));
+	}
+
+	[[nodiscard]] std::span<const std::byte> read(std::size_t size) {
+		if (size > bytes.size() - offset)
+			throw std::runtime_error{"The archive is truncated"};
+
+		return bytes.subspan(std::exchange(offset, offset + size), size);
+	}
+
+	// Values used in place, nothing is copied: the archive memory must stay alive and be aligned for Type
+	template <typename Type>
+		requires std::is_trivially_copyable_v<Type>
+	[[nodiscard]] std::span<const Type> read_array(std::size_t count) {
+		// count comes from the file, checked before it is multiplied so a corrupt one cannot wrap around
+		if (count > (bytes.size() - offset) / sizeof(Type))
+			throw std::runtime_error{"The archive is truncated"};
+
+		const auto block = read(count * sizeof(Type));
+		if (reinterpret_cast<std::uintptr_t>(block.data()) % alignof(Type) != 0)
+			throw std::runtime_error{"The archive block is misaligned"};
+
+		return {reinterpret_cast<const Type*>(block.data()), count};
+	}
+
+	void align(std::size_t alignment) {
+		offset = std::min((offset + alignment - 1) / alignment * alignment, bytes.size());
+	}
+
+	[[nodiscard]] bool empty() const noexcept {
+		return offset == bytes.size();
+	}
+
+private:
+	std::span<const std::byte> bytes;
+	std::size_t offset = 0;
+};
+
+namespace snapshot_format {
+
+enum class BlockKind : std::uint32_t {
+	entities,
+	trivial,
+	custom,
+};
+
+struct FileHeader {
+	std::array<char, 8> magic{'v', 'i', 's', 'e', 'c', 's', '\0', '\0'};
+	std::uint32_t version = 1;
+	std::uint32_t reserved = 0;
+};
+
+struct BlockHeader {
+	id_type id = 0;
+	BlockKind kind = BlockKind::entities;
+	std::uint64_t count = 0;
+	std::uint64_t element_size = 0;
+	// free list of the entity block, how many of the entities are alive
+	std::uint64_t alive = 0;
+};
+
+// cache line aligned, it covers the alignment of any component worth storing
+constexpr auto block_alignment = 64uz;
+
+} // namespace snapshot_format
+
+// Writes a registry as one block per storage. The entities of a storage and, for trivially copyable components, the
+// components themselves are stored as contiguous arrays, so SnapshotReader restores them without parsing anything.
+// Storages are read back in the order they were written.
+class SnapshotWriter {
+public:
+	explicit SnapshotWriter(const registry& reg) : reg{&reg} {
+		archive(snapshot_format::FileHeader{});
+	}
+
+	// Every entity, alive or released, so identifiers and versions come back unchanged. Has to be the first block.
+	SnapshotWriter& entities() {
+		const auto* storage = reg->storage<entity>();
+		const auto count = storage ? storage->size() : 0uz;
+
+		begin_block(snapshot_format::BlockHeader{
+				.id = type_hash<entity>::value(),
+				.kind = snapshot_format::BlockKind::entities,
+				.count = count,
+				.element_size = sizeof(entity),
+				.alive = storage ? storage->free_list() : 0uz,
+		});
+		if (count != 0)
+			archive.write(std::as_bytes(std::span{storage->data(), count}));
+		return *this;
+	}
+
+	template <typename Component>
+		requires std::is_trivially_copyable_v<Component>
+	SnapshotWriter& component(const id_type id = type_hash<Component>::value()) {
+		using traits = component_traits<Component>;
+		static_assert(not traits::in_place_delete, "Storages with tombstones cannot be written as contiguous blocks");
+
+		const auto* storage = reg->storage<Component>(id);
+		const auto count = storage ? storage->size() : 0uz;
+
+		begin_block(snapshot_format::BlockHeader{
+				.id = id,
+				.kind = snapshot_format::BlockKind::trivial,
+				.count = count,
+				.element_size = traits::page_size == 0 ? 0uz : sizeof(Component),
+		});
+		if (count == 0)
+			return *this;
+
+		archive.write(std::as_bytes(std::span{storage->data(), count}));
+
+		// empty types have no pages, the entities are all there is
+		if constexpr (traits::page_size != 0) {
+			archive.align(snapshot_format::block_alignment);
+			for (auto first = 0uz; first < count; first += traits::page_size) {
+				const auto* page = storage->raw()[first / traits::page_size];
+				archive.write(std::as_bytes(std::span{page, std::min(traits::page_size, count - first)}));
+			}
+		}
+		return *this;
+	}
+
+	// Extension point for components that cannot be copied as bytes, like RigidBody or Mesh: save(archive, component)
+	// writes whatever SnapshotReader::component needs to rebuild it.
+	template <typename Component, typename Save>
+	SnapshotWriter& component(Save&& save, const id_type id = type_hash<Component>::value()) {
+		const auto* storage = reg->storage<Component>(id);
+		const auto count = storage ? storage->size() : 0uz;
+
+		begin_block(snapshot_format::BlockHeader{
+				.id = id,
+				.kind = snapshot_format::BlockKind::custom,
+				.count = count,
+		});
+		if (count == 0)
+			return *this;
+
+		const auto entities = std::span{storage->data(), count};
+		archive.write(std::as_bytes(entities));
+		for (const auto entt : entities)
+			std::invoke(save, archive, storage->get(entt));
+		return *this;
+	}
+
+	[[nodiscard]] std::span<const std::byte> bytes() const noexcept {
+		return archive.bytes();
+	}
+
+	void save(const std::filesystem::path& path) const {
+		archive.save(path);
+	}
+
+private:
+	void begin_block(const snapshot_format::BlockHeader& header) {
+		archive.align(snapshot_format::block_alignment);
+		archive(header);
+		archive.align(snapshot_format::block_alignment);
+	}
+
+private:
+	const registry* reg;
+	BinaryOutputArchive archive;
+};
+
+// Restores what SnapshotWriter wrote into an empty registry, in the same order. Trivially copyable components are
+// copied from the snapshot memory into their storages; with a MappedFile nothing but those copies touches the data.
+class SnapshotReader {
+public:
+	explicit SnapshotReader(std::span<const std::byte> bytes) : archive{bytes} {
+		snapshot_format::FileHeader header;
+		archive(header);
+		if (header.magic != snapshot_format::FileHeader{}.magic or header.version != snapshot_format::FileHeader{}.version)
+			throw std::runtime_error{"Not a vis ecs snapshot, or one of another version"};
+	}
+
+	SnapshotReader& entities(registry& reg) {
+		const auto header = next_block(snapshot_format::BlockKind::entities, type_hash<entity>::value(), sizeof(entity));
+		const auto entities = archive.read_array<entity>(header.count);
+		if (entities.empty())
+			return *this;
+
+		auto& storage = reg.storage<entity>();
+		storage.reserve(entities.size());
+
+		auto placeholder = entity{};
+		for (const auto entt : entities) {
+			storage.generate(entt);
+			placeholder = std::max(placeholder, entt);
+		}
+
+		storage.start_from(registry::traits_type::next(placeholder));
+		storage.free_list(static_cast<std::size_t>(header.alive));
+		return *this;
+	}
+
+	template <typename Component>
+		requires std::is_trivially_copyable_v<Component>
+	SnapshotReader& component(registry& reg, const id_type id = type_hash<Component>::value()) {
+		using traits = component_traits<Component>;
+
+		const auto element_size = traits::page_size == 0 ? 0uz : sizeof(Component);
+		const auto header = next_block(snapshot_format::BlockKind::trivial, id, element_size);
+		const auto entities = archive.read_array<entity>(header.count);
+		if (entities.empty())
+			return *this;
+
+		auto& storage = reg.storage<Component>(id);
+		storage.reserve(storage.size() + entities.size());
+
+		if constexpr (traits::page_size == 0) {
+			storage.insert(entities.begin(), entities.end());
+		} else {
+			archive.align(snapshot_format::block_alignment);
+			const auto components = archive.read_array<Component>(entities.size());
+			storage.insert(entities.begin(), entities.end(), components.begin());
+		}
+		return *this;
+	}
+
+	// load(archive, entity) reads back what the save function of SnapshotWriter::component wrote and returns the rebuilt
+	// component, it can capture whatever else the component needs, such as the physics world of a RigidBody
+	template <typename Component, typename Load>
+	SnapshotReader& component(registry& reg, Load&& load, const id_type id = type_hash<Component>::value()) {
+		const auto header = next_block(snapshot_format::BlockKind::custom, id, 0);
+		const auto entities = archive.read_array<entity>(header.count);
+		if (entities.empty())
+			return *this;
+
+		auto& storage = reg.storage<Component>(id);
+		for (const auto entt : entities)
+			storage.emplace(entt, std::invoke(load, archive, entt));
+		return *this;
+	}
+
+private:
+	snapshot_format::BlockHeader next_block(snapshot_format::BlockKind kind, id_type id, std::size_t element_size) {
+		archive.align(snapshot_format::block_alignment);
+		snapshot_format::BlockHeader header;
+		archive(header);
+		archive.align(snapshot_format::block_alignment);
+
+		if (header.kind != kind or header.id != id or header.element_size != element_size)
+			throw std::runtime_error{
+					std::format("The snapshot block {} does not match the requested storage {}", header.id, id)};
+
+		return header;
+	}
+
+private:
+	BinaryInputArchive archive;
+};
+
+} // namespace vis::ecs
+
+// non exported
+namespace vis::ecs {
+
+struct BenchmarkTransform {
+	float x, y, angle;
+
+	bool operator==(const BenchmarkTransform&) const = default;
+};
+
+struct BenchmarkVelocity {
+	float x, y;
+
+	bool operator==(const BenchmarkVelocity&) const = default;
+};
+
+} // namespace vis::ecs
+
+export namespace vis::ecs {
+
+struct ArchiveBenchmark {
+	std::size_t entity_count;
+	std::size_t bytes;
+	// into memory, then from memory to the file
+	chrono::milliseconds write;
+	chrono::milliseconds save;
+	// mapping the file and restoring a new registry from it
+	chrono::milliseconds load;
+};
+
+// Round trip of a registry of entity_count entities, all with a transform and half of them with a velocity, through a
+// snapshot file in the temporary directory. Throws when the restored registry differs from the original.
+ArchiveBenchmark benchmark_archive(std::size_t entity_count = 1'000'000) {
+	registry source;
+	for (auto i = 0uz; i != entity_count; ++i) {
+		const auto entt = source.create();
+		const auto value = static_cast<float>(i);
+		source.emplace<BenchmarkTransform>(entt, value, -value, value * 0.5f);
+		if (i % 2 == 0)
+			source.emplace<BenchmarkVelocity>(entt, value * 2.0f, 1.0f);
+	}
+	const auto path = std::filesystem::temp_directory_path() / "vis_archive_benchmark.snapshot";
+
+	const auto write_start = std::chrono::steady_clock::now();
+	SnapshotWriter writer{source};
+	writer.entities().component<BenchmarkTransform>().component<BenchmarkVelocity>();
+	const auto save_start = std::chrono::steady_clock::now();
+	writer.save(path);
+	const auto load_start = std::chrono::steady_clock::now();
+	registry target;
+	{
+		const MappedFile file{path};
+		SnapshotReader{file.bytes()}.entities(target).component<BenchmarkTransform>(target).component<BenchmarkVelocity>(
+				target);
+	}
+	const auto load_end = std::chrono::steady_clock::now();
+	std::filesystem::remove(path);
+
+	const auto restored = [&]<typename Component>(std::type_identity<Component>) {
+		if (source.storage<Component>().size() != target.storage<Component>().size())
+			return false;
+		for (auto [entt, component] : source.view<Component>().each())
+			if (not target.valid(entt) or not target.all_of<Component>(entt) or target.get<Component>(entt) != component)
+				return false;
+		return true;
+	};
+	if (not restored(std::type_identity<BenchmarkTransform>{}) or not restored(std::type_identity<BenchmarkVelocity>{}))
+		throw std::runtime_error{"The snapshot round trip changed the registry"};
+
+	return ArchiveBenchmark{
+			.entity_count = entity_count,
+			.bytes = writer.bytes().size(),
+			.write = chrono::milliseconds{save_start - write_start},
+			.save = chrono::milliseconds{load_start - save_start},
+			.load = chrono::milliseconds{load_end - load_start},
+	};
+}
+
+} // namespace vis::ecs
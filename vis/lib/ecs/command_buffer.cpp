@@ -0,0 +1,271 @@
+export module vis.ecs.command_buffer;
+
+import std;
+import vis.ecs;
+import vis.memory;
+
+export namespace vis::ecs {
+
+class CommandBuffer;
+
+void apply_commands(registry& reg, std::span<CommandBuffer> buffers);
+
+// The entity a command applies to: one that already exists, or one that CommandBuffer::create() promised and that is
+// only created when the buffer is applied. A promised entity belongs to the buffer that made it.
+class CommandTarget {
+public:
+	CommandTarget(entity existing) noexcept : handle{existing} {}
+
+	[[nodiscard]] bool is_pending() const noexcept {
+		return owner != nullptr;
+	}
+
+private:
+	friend class CommandBuffer;
+	friend void apply_commands(registry& reg, std::span<CommandBuffer> buffers);
+
+	CommandTarget(const CommandBuffer* owner, std::uint32_t pending) noexcept : owner{owner}, pending{pending} {}
+
+	[[nodiscard]] entity resolve(std::span<const entity> created) const noexcept {
+		return owner ? created[pending] : handle;
+	}
+
+	entity handle = null;
+	const CommandBuffer* owner = nullptr;
+	std::uint32_t pending = 0;
+};
+
+// Structural changes recorded by one thread and played back later on the registry by the thread that owns it. Nothing
+// in it touches the registry while recording, so every thread of a parallel system can fill its own buffer.
+// Applying keeps the capacity of the buffer, a buffer reused every frame stops allocating after the first ones.
+class CommandBuffer {
+public:
+	CommandBuffer() = default;
+
+	CommandBuffer(const CommandBuffer&) = delete;
+	CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+	CommandBuffer(CommandBuffer&&) = delete;
+	CommandBuffer& operator=(CommandBuffer&&) = delete;
+
+	// The entity is created when the buffer is applied, the target can be used by the commands recorded in the meantime
+	[[nodiscard]] CommandTarget create() noexcept {
+		return CommandTarget{this, pending_count++};
+	}
+
+	void destroy(const CommandTarget& target) {
+		check_owner(target);
+		destroys.push_back(target);
+	}
+
+	// The component is built now and moved into its storage when the buffer is applied, replacing any existing one
+	template <typename Component, typename... Args> void emplace(const CommandTarget& target, Args&&... args) {
+		check_owner(target);
+		auto& typed = commands<Component>();
+		typed.commands.emplace_back(target, std::in_place, std::forward<Args>(args)...);
+		++typed.emplaces;
+	}
+
+	template <typename Component> void remove(const CommandTarget& target) {
+		check_owner(target);
+		commands<Component>().commands.emplace_back(target, std::nullopt);
+	}
+
+	[[nodiscard]] bool empty() const noexcept {
+		return pending_count == 0 and destroys.empty() and
+					 std::ranges::all_of(components, [](const auto& pair) { return pair.second->empty(); });
+	}
+
+	// Plays the commands back and clears the buffer, same as apply_commands() with this buffer alone
+	void apply(registry& reg);
+
+private:
+	friend void apply_commands(registry& reg, std::span<CommandBuffer> buffers);
+
+	struct ComponentCommands {
+		virtual ~ComponentCommands() = default;
+
+		[[nodiscard]] virtual bool empty() const noexcept = 0;
+		[[nodiscard]] virtual std::size_t emplace_count() const noexcept = 0;
+		virtual void reserve(registry& reg, std::size_t additional) const = 0;
+		virtual void apply(registry& reg, std::span<const entity> created) = 0;
+		virtual void clear() noexcept = 0;
+	};
+
+	template <typename Component> struct TypedCommands final : ComponentCommands {
+		struct Command {
+			Command(const CommandTarget& target, std::nullopt_t) noexcept : target{target} {}
+
+			template <typename... Args>
+			Command(const CommandTarget& target, std::in_place_t, Args&&... args)
+					: target{target}, component{Component{std::forward<Args>(args)...}} {}
+
+			CommandTarget target;
+			// an emplace when it holds a component, a remove otherwise
+			std::optional<Component> component;
+		};
+
+		// emplaces and removes in the order they were recorded
+		std::vector<Command> commands;
+		std::size_t emplaces = 0;
+
+		[[nodiscard]] bool empty() const noexcept override {
+			return commands.empty();
+		}
+
+		[[nodiscard]] std::size_t emplace_count() const noexcept override {
+			return emplaces;
+		}
+
+		void reserve(registry& reg, std::size_t additional) const override {
+			auto& storage = reg.storage<Component>();
+			storage.reserve(storage.size() + additional);
+		}
+
+		void apply(registry& reg, std::span<const entity> created) override {
+			auto& storage = reg.storage<Component>();
+			for (auto& [target, component] : commands) {
+				const auto entt = target.resolve(created);
+				if (not component) {
+					storage.remove(entt);
+					continue;
+				}
+				if (not reg.valid(entt))
+					continue;
+
+				if constexpr (component_traits<Component>::page_size == 0) {
+					if (not storage.contains(entt))
+						storage.emplace(entt);
+				} else if (storage.contains(entt)) {
+					storage.patch(entt, [&component](Component& current) { current = std::move(*component); });
+				} else {
+					storage.emplace(entt, std::move(*component));
+				}
+			}
+		}
+
+		void clear() noexcept override {
+			commands.clear();
+			emplaces = 0;
+		}
+	};
+
+	template <typename Component> [[nodiscard]] TypedCommands<Component>& commands() {
+		const auto id = type_hash<Component>::value();
+		auto it = std::ranges::find(components, id, &ComponentEntry::first);
+		if (it == components.end())
+			it = components.insert(it, ComponentEntry{id, std::make_unique<TypedCommands<Component>>()});
+
+		return static_cast<TypedCommands<Component>&>(*it->second);
+	}
+
+	[[nodiscard]] ComponentCommands* find(id_type id) const noexcept {
+		const auto it = std::ranges::find(components, id, &ComponentEntry::first);
+		return it == components.end() ? nullptr : it->second.get();
+	}
+
+	void check_owner(const CommandTarget& target) const {
+		if (target.owner != nullptr and target.owner != this)
+			throw std::invalid_argument{"The entity was promised by another command buffer"};
+	}
+
+	using ComponentEntry = std::pair<id_type, std::unique_ptr<ComponentCommands>>;
+
+	std::uint32_t pending_count = 0;
+	// the entities promised by create(), filled while applying
+	std::vector<entity> created;
+	std::vector<CommandTarget> destroys;
+	// one entry per component type, a handful at most, so a linear search beats hashing
+	std::vector<ComponentEntry> components;
+	// scratch of apply_commands(), lent by the first buffer applied so the sync point stops allocating too
+	std::vector<id_type> applied_components;
+	std::vector<entity> destroyed;
+};
+
+// Sync point for commands recorded in parallel. The buffers are played back in three phases, each one in bulk:
+//  - the promised entities of every buffer are created;
+//  - component by component, the emplaces and removes of every buffer go into that storage in the order they were
+//    recorded, so one storage is touched at a time;
+//  - the destroyed entities of every buffer are destroyed once each, an entity destroyed by two systems is fine.
+// Commands of one buffer keep their order within a component; across buffers, the buffer order decides.
+void apply_commands(registry& reg, std::span<CommandBuffer> buffers) {
+	if (buffers.empty())
+		return;
+
+	memory::AllocationScope allocation_scope{memory::AllocationTag::ecs};
+	auto& component_ids = buffers.front().applied_components;
+	auto& destroyed = buffers.front().destroyed;
+	component_ids.clear();
+	destroyed.clear();
+
+	for (auto& buffer : buffers) {
+		buffer.created.resize(buffer.pending_count);
+		reg.create(buffer.created.begin(), buffer.created.end());
+	}
+
+	for (const auto& buffer : buffers)
+		for (const auto& [id, commands] : buffer.components)
+			if (not commands->empty() and std::ranges::find(component_ids, id) == component_ids.end())
+				component_ids.push_back(id);
+
+	for (const auto id : component_ids) {
+		const CommandBuffer::ComponentCommands* first = nullptr;
+		auto additional = 0uz;
+		for (const auto& buffer : buffers)
+			if (const auto* commands = buffer.find(id)) {
+				first = first ? first : commands;
+				additional += commands->emplace_count();
+			}
+		first->reserve(reg, additional);
+
+		for (auto& buffer : buffers)
+			if (auto* commands = buffer.find(id))
+				commands->apply(reg, buffer.created);
+	}
+
+	for (const auto& buffer : buffers)
+		for (const auto& target : buffer.destroys)
+			destroyed.push_back(target.resolve(buffer.created));
+
+	std::ranges::sort(destroyed);
+	const auto [duplicates_begin, duplicates_end] = std::ranges::unique(destroyed);
+	destroyed.erase(duplicates_begin, duplicates_end);
+	std::erase_if(destroyed, [&reg](entity entt) { return not reg.valid(entt); });
+	reg.destroy(destroyed.begin(), destroyed.end());
+
+	for (auto& buffer : buffers) {
+		buffer.pending_count = 0;
+		buffer.created.clear();
+		buffer.destroys.clear();
+		for (auto& [id, commands] : buffer.components)
+			commands->clear();
+	}
+}
+
+void CommandBuffer::apply(registry& reg) {
+	apply_commands(reg, std::span{this, 1});
+}
+
+// One CommandBuffer per slot. A parallel system records into the buffer of the slot it runs on, for instance the index
+// given by ThreadPool::parallel_for, and the owner of the registry applies them all at the sync point.
+class CommandBuffers {
+public:
+	explicit CommandBuffers(std::size_t slot_count) : buffers(slot_count) {}
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return buffers.size();
+	}
+
+	[[nodiscard]] CommandBuffer& operator[](std::size_t slot) noexcept {
+		return buffers[slot];
+	}
+
+	void apply(registry& reg) {
+		apply_commands(reg, buffers);
+	}
+
+private:
+	std::vector<CommandBuffer> buffers;
+};
+
+} // namespace vis::ecs
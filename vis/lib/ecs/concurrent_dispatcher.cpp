@@ -0,0 +1,96 @@
+export module vis.ecs.concurrent_dispatcher;
+
+import std;
+import vis.ecs;
+import vis.jobs;
+
+export namespace vis::ecs {
+
+// A dispatcher whose queues can be fed from any thread: the SDL event callback, the network, the workers of a job. Each
+// event type has a lock-free MpscQueue of its own, and update() drains them on the thread that owns the dispatcher,
+// where the listeners run.
+//
+// The event types are set up by the owning thread, with sink() or reserve(), before other threads get to enqueue: an
+// enqueue() only looks the queue up, so producers never race with a queue being added.
+class ConcurrentDispatcher {
+public:
+	explicit ConcurrentDispatcher(std::size_t default_capacity = 256) : default_capacity{default_capacity} {}
+
+	ConcurrentDispatcher(const ConcurrentDispatcher&) = delete;
+	ConcurrentDispatcher& operator=(const ConcurrentDispatcher&) = delete;
+
+	// Owning thread. Creates the queue of the event type, with room for capacity events between two updates.
+	template <typename Event> void reserve(std::size_t capacity) {
+		assure<Event>(capacity);
+	}
+
+	// Owning thread
+	template <typename Event> [[nodiscard]] auto sink() {
+		return ecs::sink<sigh<void(Event&)>>{assure<Event>(default_capacity).signal};
+	}
+
+	// Any thread. Returns false, and drops the event, when its queue is full.
+	template <typename Event> bool enqueue(Event event) {
+		return find<Event>().queue.try_push(std::move(event));
+	}
+
+	// Owning thread, the listeners run right away
+	template <typename Event> void trigger(Event event) {
+		assure<Event>(default_capacity).signal.publish(event);
+	}
+
+	// Owning thread. Delivers the events of every type queued so far, type by type.
+	void update() {
+		for (auto& [id, pool] : pools)
+			pool->publish();
+	}
+
+	template <typename Event> void update() {
+		assure<Event>(default_capacity).publish();
+	}
+
+private:
+	struct EventPool {
+		virtual ~EventPool() = default;
+
+		virtual void publish() = 0;
+	};
+
+	template <typename Event> struct TypedPool final : EventPool {
+		explicit TypedPool(std::size_t capacity) : queue{capacity} {}
+
+		// One batch of at most a full queue: producers that keep pushing do not hold the owning thread in here, what they
+		// push meanwhile waits for the next update
+		void publish() override {
+			queue.consume([this](Event&& event) { signal.publish(event); }, queue.capacity());
+		}
+
+		jobs::MpscQueue<Event> queue;
+		sigh<void(Event&)> signal;
+	};
+
+	using PoolEntry = std::pair<id_type, std::unique_ptr<EventPool>>;
+
+	template <typename Event> [[nodiscard]] TypedPool<Event>& assure(std::size_t capacity) {
+		const auto id = type_hash<Event>::value();
+		auto it = std::ranges::find(pools, id, &PoolEntry::first);
+		if (it == pools.end())
+			it = pools.insert(it, PoolEntry{id, std::make_unique<TypedPool<Event>>(capacity)});
+
+		return static_cast<TypedPool<Event>&>(*it->second);
+	}
+
+	template <typename Event> [[nodiscard]] TypedPool<Event>& find() {
+		const auto it = std::ranges::find(pools, type_hash<Event>::value(), &PoolEntry::first);
+		if (it == pools.end())
+			throw std::invalid_argument{"The event type was not set up with sink() or reserve() before enqueuing"};
+
+		return static_cast<TypedPool<Event>&>(*it->second);
+	}
+
+	std::size_t default_capacity;
+	// one entry per event type, a handful at most, so a linear search beats hashing
+	std::vector<PoolEntry> pools;
+};
+
+} // namespace vis::ecs
@@ -9,7 +9,9 @@ export module vis.graphic.mesh;
 
 import std;
 import vis.graphic.opengl;
+import vis.graphic.render_queue;
 import vis.math;
+import vis.memory;
 
 #ifdef NDEBUG
 #define CHECK_LAST_GL_CALL
@@ -55,14 +57,15 @@ public:
 layout (location = 0) in vec2 pos;
 layout (location = 1) in vec4 col;
 
-uniform mat4 model_view_projection;
+uniform mat3x2 model_view_projection;
+uniform vec4 tint;
 
 out vec4 vertex_color;
 
 void main()
 {
-    gl_Position = model_view_projection * vec4(pos.xy, 0.0f, 1.0f);
-		vertex_color = col;
+    gl_Position = vec4(model_view_projection * vec3(pos.xy, 1.0f), 0.0f, 1.0f);
+		vertex_color = col * tint;
 }
 )"))
 										 .add_shader(gl::Shader::create(gl::ShaderType::fragment, R"(
@@ -77,7 +80,12 @@ void main()
 		fragment_color = vertex_color;
 }
       )"))
-										 .build()} {}
+										 .build()} {
+		// uniforms start at zero, a white tint keeps the vertex colors
+		bind();
+		set_tint(vec4{1.0f});
+		unbind();
+	}
 
 	MeshShader(MeshShader&) = delete;
 	MeshShader& operator=(MeshShader&) = delete;
@@ -85,11 +93,17 @@ void main()
 	MeshShader(MeshShader&&) = default;
 	MeshShader& operator=(MeshShader&&) = default;
 
-	MeshShader& set_model_view_projection(const mat4& m) {
+	MeshShader& set_model_view_projection(const Affine2D& m) {
 		program.set_uniform("model_view_projection", m);
 		return *this;
 	}
 
+	// Multiplies the vertex colors, white meshes take the color of the tint
+	MeshShader& set_tint(const vec4& color) {
+		program.set_uniform("tint", color);
+		return *this;
+	}
+
 	void bind() const {
 		program.use();
 	}
@@ -139,10 +153,16 @@ public:
 
 	void draw([[maybe_unused]] const MeshShader& mesh_shader) const {
 		bind();
-		glDrawArrays(draw_descriptor.mode, draw_descriptor.first, draw_descriptor.vertex_count);
+		draw_bound();
 		unbind();
 	}
 
+	// Draws without touching the vertex array binding, the mesh must be bound already
+	void draw_bound() const {
+		glDrawArrays(draw_descriptor.mode, draw_descriptor.first, draw_descriptor.vertex_count);
+		CHECK_LAST_GL_CALL;
+	}
+
 private:
 	gl::VertexArrayObject vao;
 	gl::VertexBufferObject vbo;
@@ -260,4 +280,43 @@ Mesh create_rectangle_shape(const vec2& center, const vec2& half_extent, vec4 co
 	return Mesh{vertexes, vertex_descriptions, draw_description};
 }
 
+// Draws a render queue with white unit meshes tinted per draw. The queue is sorted by mesh, so the vertex array is only
+// rebound when the mesh changes; the program stays bound for the whole queue.
+class QueueBackend final : public render::RenderBackend {
+public:
+	QueueBackend()
+			: quad{create_rectangle_shape(vec2{}, vec2{1.0f}, vec4{1.0f})},
+				circle{create_regular_shape(vec2{}, 1.0f, vec4{1.0f}, circle_segments)} {}
+
+	void submit(const render::RenderQueue& queue, const Affine2D& view_projection) override {
+		memory::AllocationScope allocation_scope{memory::AllocationTag::gl};
+		if (queue.empty())
+			return;
+
+		shader.bind();
+		const Mesh* bound_mesh = nullptr;
+		for (const auto& packet : queue.sorted()) {
+			const auto& mesh = packet.mesh == render::MeshId::circle ? circle : quad;
+			if (&mesh != bound_mesh) {
+				mesh.bind();
+				bound_mesh = &mesh;
+			}
+
+			shader.set_model_view_projection(view_projection * render::model_transform(packet.transform))
+					.set_tint(packet.color);
+			mesh.draw_bound();
+		}
+
+		bound_mesh->unbind();
+		shader.unbind();
+	}
+
+private:
+	static constexpr int circle_segments = 32;
+
+	MeshShader shader;
+	Mesh quad;
+	Mesh circle;
+};
+
 } // namespace vis::mesh
\ No newline at end of file
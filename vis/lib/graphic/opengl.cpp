@@ -23,6 +23,7 @@ export module vis.graphic.opengl;
 import std;
 import vis.math;
 import vis.window;
+import vis.memory;
 
 export namespace vis::gl {
 
@@ -274,6 +275,19 @@ public:
 		CHECK_LAST_GL_CALL;
 	}
 
+	// uploaded as the mat3x2 it is laid out as
+	void set_uniform(std::string_view name, const Affine2D& m) {
+		const auto loc = get_or_update_uniform(name);
+		glUniformMatrix3x2fv(loc, 1, GL_FALSE, gtc::value_ptr(m.x_axis));
+		CHECK_LAST_GL_CALL;
+	}
+
+	void set_uniform(std::string_view name, const vec4& v) {
+		const auto loc = get_or_update_uniform(name);
+		glUniform4fv(loc, 1, gtc::value_ptr(v));
+		CHECK_LAST_GL_CALL;
+	}
+
 	static void unbind() {
 		glUseProgram(0);
 		CHECK_LAST_GL_CALL;
@@ -424,6 +438,7 @@ public:
 	}
 
 	void render() const {
+		memory::AllocationScope allocation_scope{memory::AllocationTag::gl};
 		SDL_GL_SwapWindow(static_cast<SDL_Window*>(*window));
 	}
 
@@ -0,0 +1,136 @@
+export module vis.graphic.render_queue;
+
+import std;
+import vis.math;
+
+export namespace vis::render {
+
+// Unit shapes the draw packets scale, rotate and move into place
+enum class MeshId : std::uint8_t {
+	quad,
+	circle,
+};
+
+struct Transform2D {
+	vec2 position{};
+	// cosine and sine of the rotation angle
+	vec2 rotation{1.0f, 0.0f};
+	// half extent of a quad, radius of a circle
+	vec2 scale{1.0f, 1.0f};
+};
+
+struct DrawPacket {
+	Transform2D transform;
+	MeshId mesh = MeshId::quad;
+	vec4 color{};
+};
+
+// Maps the unit mesh to the world, for backends that transform on the GPU
+[[nodiscard]] Affine2D model_transform(const Transform2D& transform) noexcept {
+	return Affine2D::from_trs(transform.position, transform.rotation, transform.scale);
+}
+
+// Fields of the 64 bit sort key, from the most to the least significant: layer (8 bits), pipeline (8 bits), mesh (16
+// bits) and depth (32 bits). Draws are issued in increasing key order, so within a layer everything using the same
+// pipeline and then the same mesh ends up next to each other.
+struct DrawKey {
+	std::uint8_t layer = 0;
+	std::uint8_t pipeline = 0;
+	std::uint16_t mesh = 0;
+	// smaller depths are drawn first
+	float depth = 0.0f;
+
+	[[nodiscard]] std::uint64_t pack() const noexcept {
+		// flips the float bits so that their unsigned order matches the float order, negative values included
+		const auto depth_bits = std::bit_cast<std::uint32_t>(depth);
+		const auto ordered_depth = (depth_bits & 0x8000'0000u) != 0 ? ~depth_bits : depth_bits | 0x8000'0000u;
+
+		return std::uint64_t{layer} << 56 | std::uint64_t{pipeline} << 48 | std::uint64_t{mesh} << 32 | ordered_depth;
+	}
+};
+
+// Draws emitted by the systems of one frame. Packets are stored in emission order and sorted by key once per frame
+// with a radix sort, which is linear in the number of draws and stable, so draws with the same key keep their order.
+class RenderQueue {
+public:
+	struct Command {
+		std::uint64_t key = 0;
+		std::uint32_t index = 0;
+	};
+
+	void push(const DrawKey& key, const DrawPacket& packet) {
+		commands.push_back(Command{key.pack(), static_cast<std::uint32_t>(packets.size())});
+		packets.push_back(packet);
+	}
+
+	// Every built-in mesh has its own pipeline in both backends, so both key fields follow the mesh id
+	void push(const DrawPacket& packet, std::uint8_t layer = 0, float depth = 0.0f) {
+		const auto mesh = std::to_underlying(packet.mesh);
+		push(DrawKey{.layer = layer, .pipeline = mesh, .mesh = mesh, .depth = depth}, packet);
+	}
+
+	// Keeps the capacity, a queue refilled every frame stops allocating after the first frames
+	void clear() noexcept {
+		commands.clear();
+		packets.clear();
+	}
+
+	// Least significant digit first, one byte per pass. Passes over a byte every key shares, such as an unused depth,
+	// are skipped.
+	void sort() {
+		if (commands.size() < 2)
+			return;
+
+		constexpr auto digit_count = sizeof(std::uint64_t);
+		std::array<std::array<std::uint32_t, 256>, digit_count> histograms{};
+		for (const auto& command : commands)
+			for (auto digit = 0uz; digit < digit_count; ++digit)
+				++histograms[digit][(command.key >> (digit * 8)) & 0xff];
+
+		scratch.resize(commands.size());
+		for (auto digit = 0uz; digit < digit_count; ++digit) {
+			const auto shift = digit * 8;
+			auto& histogram = histograms[digit];
+			if (histogram[(commands.front().key >> shift) & 0xff] == commands.size())
+				continue;
+
+			std::uint32_t offset = 0;
+			for (auto& count : histogram)
+				offset += std::exchange(count, offset);
+
+			for (const auto& command : commands)
+				scratch[histogram[(command.key >> shift) & 0xff]++] = command;
+			std::swap(commands, scratch);
+		}
+	}
+
+	// Packets in key order once sort() ran, in emission order before
+	[[nodiscard]] auto sorted() const noexcept {
+		return commands | std::views::transform([this](const Command& command) -> const DrawPacket& {
+						 return packets[command.index];
+					 });
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return packets.size();
+	}
+
+	[[nodiscard]] bool empty() const noexcept {
+		return packets.empty();
+	}
+
+private:
+	std::vector<Command> commands;
+	std::vector<Command> scratch;
+	std::vector<DrawPacket> packets;
+};
+
+// Translates a sorted queue into the calls of one graphic API, so the same scene code drives vis::gl and vis::vulkan
+class RenderBackend {
+public:
+	virtual ~RenderBackend() = default;
+
+	virtual void submit(const RenderQueue& queue, const Affine2D& view_projection) = 0;
+};
+
+} // namespace vis::render
@@ -0,0 +1,223 @@
+export module vis.graphic.vulkan.render_thread;
+
+import std;
+import vis.math;
+import vis.chrono;
+import vis.jobs;
+import vis.memory;
+import vis.window;
+import vis.graphic.render_queue;
+import vis.graphic.vulkan;
+
+export namespace vis::vulkan {
+
+// Turns a render queue into the shape batch of the renderer. The batch draws all the quads and then all the circles
+// with one instanced draw each, so the key order holds within each mesh but layers do not interleave across meshes.
+class QueueBackend final : public render::RenderBackend {
+public:
+  explicit QueueBackend(Renderer& renderer) noexcept : renderer{renderer} {}
+
+  void submit(const render::RenderQueue& queue, const Affine2D& view_projection) override {
+    renderer.set_view_projection(view_projection);
+
+    auto& shapes = renderer.shapes();
+    for (const auto& packet : queue.sorted()) {
+      const auto& transform = packet.transform;
+      switch (packet.mesh) {
+      case render::MeshId::quad:
+        shapes.add_rectangle(transform.position, transform.scale, packet.color, transform.rotation);
+        break;
+      case render::MeshId::circle:
+        shapes.add_circle(transform.position, transform.scale.x, packet.color);
+        break;
+      }
+    }
+  }
+
+private:
+  Renderer& renderer;
+};
+
+// Everything the render thread needs to draw one simulation frame, nothing in it points back into the simulation
+struct RenderSnapshot {
+  std::uint64_t sequence = 0;
+  int viewport_width = 0;
+  int viewport_height = 0;
+  vec4 clear_color{};
+  Affine2D view_projection{};
+  // sorted by the render thread
+  render::RenderQueue queue;
+  // inputs whose effect the snapshot shows and whose latency was not measured yet, oldest first
+  std::array<win::Timestamp, 8> inputs{};
+  std::size_t input_count = 0;
+};
+
+// From the timestamp of an input event to the return of the present call of the first frame showing its effect
+struct InputLatencyStats {
+  std::uint64_t count = 0;
+  chrono::milliseconds last{};
+  chrono::milliseconds min{};
+  chrono::milliseconds max{};
+  chrono::milliseconds total{};
+
+  [[nodiscard]] chrono::milliseconds average() const noexcept {
+    return count == 0 ? chrono::milliseconds{} : total / static_cast<float>(count);
+  }
+};
+
+// Owns the thread that drives the renderer. The simulation fills a snapshot and publishes it through a triple buffer,
+// so simulating frame N+1 overlaps rendering frame N and a present blocked on vsync only stalls the render thread.
+// Once the first snapshot is published, the renderer belongs to the render thread and nobody else may use it.
+class RenderThread {
+public:
+  explicit RenderThread(Renderer& renderer) : renderer{renderer}, backend{renderer} {
+    thread = std::jthread{[this](std::stop_token stop_token) { run(stop_token); }};
+  }
+
+  RenderThread(const RenderThread&) = delete;
+  RenderThread& operator=(const RenderThread&) = delete;
+
+  ~RenderThread() {
+    thread.request_stop();
+    // wakes the render thread up if it is waiting for a snapshot, the jthread joins it
+    published.fetch_add(1, std::memory_order_release);
+    published.notify_one();
+  }
+
+  // Simulation side. The snapshot is recycled, clear it and fill it again before every publish()
+  [[nodiscard]] RenderSnapshot& snapshot() noexcept {
+    return snapshots.write_buffer();
+  }
+
+  // Simulation side. The input was applied to the simulation, its latency is measured when the first snapshot
+  // published from now on is presented.
+  void track_input(win::Timestamp timestamp) noexcept {
+    if (tracked_inputs.size() == tracked_inputs.capacity())
+      tracked_inputs.erase(tracked_inputs.begin());
+    tracked_inputs.push_back(TrackedInput{timestamp, published_sequence + 1});
+  }
+
+  void publish() noexcept {
+    // a snapshot may be replaced before the render thread reads it, so an input stays in every snapshot until one of
+    // them is picked up
+    const auto picked = picked_up.load(std::memory_order_acquire);
+    std::erase_if(tracked_inputs, [picked](const TrackedInput& input) { return input.first_sequence <= picked; });
+
+    auto& snapshot = snapshots.write_buffer();
+    snapshot.input_count = std::min(tracked_inputs.size(), snapshot.inputs.size());
+    for (auto i = 0uz; i < snapshot.input_count; ++i)
+      snapshot.inputs[i] = tracked_inputs[i].timestamp;
+
+    snapshot.sequence = ++published_sequence;
+    snapshots.publish();
+    published.store(published_sequence, std::memory_order_release);
+    published.notify_one();
+  }
+
+  // Keeps the simulation at most one snapshot ahead of the renderer: returns once the render thread picked up every
+  // snapshot but the last one published. It waits on an atomic, never on a mutex.
+  void wait_for_render() const noexcept {
+    const auto target = published_sequence - 1;
+    for (auto seen = picked_up.load(std::memory_order_acquire); seen < target;
+         seen = picked_up.load(std::memory_order_acquire))
+      picked_up.wait(seen, std::memory_order_acquire);
+  }
+
+  // Simulation side. The latest stats the render thread published, they lag the presented frames by at most one.
+  [[nodiscard]] InputLatencyStats input_latency() noexcept {
+    published_latency.update();
+    return published_latency.read_buffer();
+  }
+
+private:
+  void run(std::stop_token stop_token) {
+    memory::AllocationScope allocation_scope{memory::AllocationTag::vk};
+    std::uint64_t seen = 0;
+    while (not stop_token.stop_requested()) {
+      published.wait(seen, std::memory_order_acquire);
+      seen = published.load(std::memory_order_acquire);
+
+      if (not snapshots.update())
+        continue;
+
+      auto& latest = snapshots.read_buffer();
+      picked_up.store(latest.sequence, std::memory_order_release);
+      picked_up.notify_one();
+
+      render(latest);
+    }
+  }
+
+  void render(RenderSnapshot& latest) {
+    if (latest.viewport_width != viewport_width or latest.viewport_height != viewport_height) {
+      viewport_width = latest.viewport_width;
+      viewport_height = latest.viewport_height;
+      renderer.set_viewport(0, 0, viewport_width, viewport_height);
+    }
+
+    renderer.set_clear_color(latest.clear_color);
+
+    latest.queue.sort();
+    backend.submit(latest.queue, latest.view_projection);
+
+    renderer.render();
+    measure_input_latency(latest, win::ticks());
+    renderer.wait_for_next_frame();
+  }
+
+  // An input carried by several snapshots is measured on the first one presented, timestamps only grow. The stats stay
+  // on the render thread and a copy is published only when an input was measured, so a frame never takes a lock.
+  void measure_input_latency(const RenderSnapshot& latest, win::Timestamp presented) {
+    const auto measured = latency.count;
+    for (const auto timestamp : std::span{latest.inputs}.first(latest.input_count)) {
+      if (timestamp <= last_measured_input)
+        continue;
+
+      last_measured_input = timestamp;
+      const chrono::milliseconds input_latency = presented - timestamp;
+      latency.min = latency.count == 0 ? input_latency : std::min(latency.min, input_latency);
+      latency.max = std::max(latency.max, input_latency);
+      latency.last = input_latency;
+      latency.total += input_latency;
+      ++latency.count;
+    }
+
+    if (latency.count != measured) {
+      published_latency.write_buffer() = latency;
+      published_latency.publish();
+    }
+  }
+
+private:
+  Renderer& renderer;
+  QueueBackend backend;
+  vis::jobs::TripleBuffer<RenderSnapshot> snapshots;
+
+  struct TrackedInput {
+    win::Timestamp timestamp;
+    std::uint64_t first_sequence;
+  };
+
+  // written by the simulation only
+  std::uint64_t published_sequence = 0;
+  // reserved once, the oldest input is dropped when a burst overflows a snapshot
+  std::vector<TrackedInput> tracked_inputs = [] {
+    std::vector<TrackedInput> inputs;
+    inputs.reserve(std::tuple_size_v<decltype(RenderSnapshot::inputs)>);
+    return inputs;
+  }();
+  std::atomic<std::uint64_t> published{0};
+  // written by the render thread only
+  std::atomic<std::uint64_t> picked_up{0};
+  int viewport_width = 0;
+  int viewport_height = 0;
+  win::Timestamp last_measured_input{};
+  InputLatencyStats latency;
+  // from the render thread to the simulation
+  vis::jobs::TripleBuffer<InputLatencyStats> published_latency;
+
+  // last, so it starts once everything it uses is constructed and stops before any of it is destroyed
+  std::jthread thread;
+};
+
+} // namespace vis::vulkan
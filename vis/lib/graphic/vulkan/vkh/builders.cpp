@@ -353,6 +353,11 @@ public:
     return *this;
   }
 
+  DeviceCreateInfoBuilder& with_features(const VkPhysicalDeviceFeatures& enabled_features) noexcept {
+    features = enabled_features;
+    return *this;
+  }
+
   DeviceCreateInfoBuilder& add_required_extension(const char* extension_name) noexcept {
     extensions.push_back(extension_name);
     return *this;
@@ -392,6 +397,10 @@ private:
 class Context {
 public:
   Context() {
+    // a window initializes the loader on its own, headless users rely on the context to do it
+    if (volkGetInstanceVersion() == 0 and volkInitialize() != VK_SUCCESS)
+      throw std::runtime_error{"Unable to load the Vulkan loader"};
+
     api_version = volkGetInstanceVersion();
     available_layers = enumerate<VkLayerProperties>(vkEnumerateInstanceLayerProperties);
     available_extensions = enumerate<VkExtensionProperties>(vkEnumerateInstanceExtensionProperties, nullptr);
@@ -484,7 +493,7 @@ public:
     if (instance == VK_NULL_HANDLE)
       return;
 
-    vkDestroyInstance(instance, nullptr);
+    vkDestroyInstance(instance, helper::allocation_callbacks());
   }
 
   // TODO: serialize
@@ -605,7 +614,7 @@ public:
     auto required_api_version = std::max(minimum_instance_version, maximum_instance_version);
     auto app_info = app_info_builder.with_api_version(required_api_version).build();
     auto create_info = instance_create_info_builder.with_application_info(&app_info).build();
-    auto native_instance = context.create_instance(create_info, nullptr);
+    auto native_instance = context.create_instance(create_info, helper::allocation_callbacks());
 
     return {&context, native_instance, required_api_version, enabled_layers, enabled_extensions};
   }
@@ -649,7 +658,7 @@ public:
     if (handle == VK_NULL_HANDLE)
       return;
 
-    vkDestroySurfaceKHR(*instance, handle, nullptr);
+    vkDestroySurfaceKHR(*instance, handle, helper::allocation_callbacks());
   }
 
   operator NativeHandle() const noexcept {
@@ -669,7 +678,7 @@ public:
   explicit SurfaceBuilder(Instance* instance, ::vis::Window* window) : instance{instance}, window{window} {}
 
   [[nodiscard]] Surface build() const noexcept {
-    auto vk_surface = window->create_renderer_surface(*instance, nullptr);
+    auto vk_surface = window->create_renderer_surface(*instance, helper::allocation_callbacks());
     return {instance, vk_surface};
   }
 
@@ -684,6 +693,29 @@ class SubmitInfo {
 public:
   using NativeType = VkSubmitInfo;
 
+  // the native struct points into the arrays below, so copies have to re-link it
+  SubmitInfo(const SubmitInfo& other)
+      : native_type{other.native_type}, timeline_info{other.timeline_info}, next{other.next},
+        wait_semaphores{other.wait_semaphores},
+        wait_stages{other.wait_stages}, wait_values{other.wait_values}, command_buffers{other.command_buffers},
+        signal_semaphores{other.signal_semaphores}, signal_values{other.signal_values} {
+    link();
+  }
+
+  SubmitInfo& operator=(const SubmitInfo& other) {
+    native_type = other.native_type;
+    timeline_info = other.timeline_info;
+    next = other.next;
+    wait_semaphores = other.wait_semaphores;
+    wait_stages = other.wait_stages;
+    wait_values = other.wait_values;
+    command_buffers = other.command_buffers;
+    signal_semaphores = other.signal_semaphores;
+    signal_values = other.signal_values;
+    link();
+    return *this;
+  }
+
   operator const NativeType*() const noexcept {
     return &native_type;
   }
@@ -693,10 +725,42 @@ public:
   }
 
 private:
-  explicit SubmitInfo(const NativeType& native) : native_type{native} {}
+  SubmitInfo() noexcept = default;
+
+  void link() noexcept {
+    native_type.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size());
+    native_type.pWaitSemaphores = wait_semaphores.data();
+    native_type.pWaitDstStageMask = wait_stages.data();
+    native_type.commandBufferCount = static_cast<uint32_t>(command_buffers.size());
+    native_type.pCommandBuffers = command_buffers.data();
+    native_type.signalSemaphoreCount = static_cast<uint32_t>(signal_semaphores.size());
+    native_type.pSignalSemaphores = signal_semaphores.data();
+    native_type.pNext = next;
+
+    // binary semaphores ignore their value, the struct is only needed when a timeline semaphore takes part
+    const bool has_timeline = std::ranges::any_of(wait_values, [](uint64_t value) { return value != 0; }) or
+                              std::ranges::any_of(signal_values, [](uint64_t value) { return value != 0; });
+    if (not has_timeline)
+      return;
+
+    timeline_info.pNext = next;
+    timeline_info.waitSemaphoreValueCount = static_cast<uint32_t>(wait_values.size());
+    timeline_info.pWaitSemaphoreValues = wait_values.data();
+    timeline_info.signalSemaphoreValueCount = static_cast<uint32_t>(signal_values.size());
+    timeline_info.pSignalSemaphoreValues = signal_values.data();
+    native_type.pNext = &timeline_info;
+  }
 
 private:
-  NativeType native_type;
+  NativeType native_type{.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO};
+  VkTimelineSemaphoreSubmitInfo timeline_info{.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+  const void* next = nullptr;
+  std::vector<VkSemaphore> wait_semaphores;
+  std::vector<VkPipelineStageFlags> wait_stages;
+  std::vector<uint64_t> wait_values;
+  std::vector<VkCommandBuffer> command_buffers;
+  std::vector<VkSemaphore> signal_semaphores;
+  std::vector<uint64_t> signal_values;
 };
 
 class PresentInfo {
@@ -744,6 +808,7 @@ public:
   void wait_for(std::chrono::nanoseconds timeout) const noexcept;
   void wait() const noexcept;
   void reset() const noexcept;
+  [[nodiscard]] bool is_signaled() const noexcept;
 
 private:
   Fence(NativeHandle handle, Device* device);
@@ -777,9 +842,9 @@ public:
     return true;
   }
 
-  bool present(const PresentInfo& present_info) const noexcept {
-    vkQueuePresentKHR(handle, static_cast<const PresentInfo::NativeType*>(present_info));
-    return true;
+  PresentResult present(const PresentInfo& present_info) const noexcept {
+    auto res = vkQueuePresentKHR(handle, static_cast<const PresentInfo::NativeType*>(present_info));
+    return static_cast<PresentResult>(res);
   }
 
 private:
@@ -815,7 +880,7 @@ public:
       return;
 
     wait_for_idle();
-    vkDestroyDevice(handle, nullptr);
+    vkDestroyDevice(handle, helper::allocation_callbacks());
   }
 
   operator NativeHandle() const noexcept {
@@ -991,6 +1056,28 @@ public:
     return false;
   }
 
+  bool has_timeline_semaphore() const noexcept {
+    return timeline_semaphore_supported;
+  }
+
+  // Statistics queries are only usable around secondary command buffers when they can be inherited too
+  bool has_pipeline_statistics_query() const noexcept {
+    return features.features.pipelineStatisticsQuery == VK_TRUE and features.features.inheritedQueries == VK_TRUE;
+  }
+
+  // Nanoseconds per timestamp tick
+  float timestamp_period() const noexcept {
+    return properties.properties.limits.timestampPeriod;
+  }
+
+  // Zero when the queue family cannot write timestamps
+  uint32_t timestamp_valid_bits(std::size_t queue_family_index) const noexcept {
+    if (queue_family_index >= available_queue_families.size())
+      return 0;
+
+    return available_queue_families[queue_family_index].queueFamilyProperties.timestampValidBits;
+  }
+
   bool has_graphic_queue() const noexcept {
     return has_queue(QueueFlagBits::Graphics);
   }
@@ -1018,6 +1105,16 @@ public:
     return std::ranges::find_if(available_extensions, match_extension) != end(available_extensions);
   }
 
+  std::optional<std::size_t> get_first_graphic_queue_family_index() const noexcept {
+    for (std::size_t i = 0u; i < available_queue_families.size(); ++i) {
+      const auto& queue = available_queue_families[i].queueFamilyProperties;
+      if (queue.queueCount > 0 && (queue.queueFlags & static_cast<VkQueueFlags>(QueueFlagBits::Graphics)))
+        return i;
+    }
+
+    return std::nullopt;
+  }
+
   std::optional<std::size_t> get_first_graphic_and_present_queue_family_index() const noexcept {
     for (std::size_t i = 0u; i < available_queue_families.size(); ++i) {
       const auto& queue = available_queue_families[i].queueFamilyProperties;
@@ -1029,6 +1126,23 @@ public:
     return std::nullopt;
   }
 
+  const VkPhysicalDeviceMemoryProperties& get_memory_properties() const noexcept {
+    return memory_properties;
+  }
+
+  std::optional<uint32_t> find_memory_type_index(uint32_t memory_type_bits,
+                                                  MemoryPropertyFlags required_properties) const noexcept {
+    const auto required = static_cast<MemoryPropertyFlags::MaskType>(required_properties);
+    for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i) {
+      const bool is_allowed = (memory_type_bits & (1u << i)) != 0;
+      const bool has_properties = (memory_properties.memoryTypes[i].propertyFlags & required) == required;
+      if (is_allowed and has_properties)
+        return i;
+    }
+
+    return std::nullopt;
+  }
+
   template <std::ranges::range R>
     requires std::convertible_to<std::ranges::range_value_t<R>, std::string_view>
   bool has_extensions(R requested_extensions) const noexcept {
@@ -1044,9 +1158,16 @@ private:
   PhysicalDevice(NativeHandle device, Surface* surface) noexcept : handle{device}, surface{surface} {
     init_features2();
     init_properties2();
+    init_timeline_semaphore_support();
     init_layers();
     init_extensions();
     init_queue_famylies();
+    init_memory_properties();
+
+    // headless devices have no surface to query
+    if (surface == nullptr)
+      return;
+
     init_surface_support_map();
     init_surface_capabilities();
     init_surface_formats2();
@@ -1061,6 +1182,22 @@ private:
     properties = PhysicalDevice::get_properties2(handle);
   }
 
+  void init_timeline_semaphore_support() noexcept {
+    // vkWaitSemaphores and friends are core from 1.2, older devices are not worth the extension entry points
+    if (device_api_version() < VK_API_VERSION_1_2)
+      return;
+
+    auto timeline_features = VkPhysicalDeviceTimelineSemaphoreFeatures{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+        .pNext = nullptr,
+        .timelineSemaphore = VK_FALSE,
+    };
+    auto query =
+        PhysicalDeviceFeatures2Builder{}.with_next(reinterpret_cast<VkBaseInStructure*>(&timeline_features)).build();
+    vkGetPhysicalDeviceFeatures2(handle, static_cast<VkPhysicalDeviceFeatures2*>(query));
+    timeline_semaphore_supported = timeline_features.timelineSemaphore == VK_TRUE;
+  }
+
   void init_layers() noexcept {
     available_layers = PhysicalDevice::get_layers(handle);
   }
@@ -1078,6 +1215,10 @@ private:
     available_queue_families = PhysicalDevice::get_queue_famylies(handle);
   }
 
+  void init_memory_properties() noexcept {
+    vkGetPhysicalDeviceMemoryProperties(handle, &memory_properties);
+  }
+
   void init_surface_support_map() noexcept {
     assert(surface != nullptr && "You mush assign the surface before");
     for (auto i = 0u; i < available_queue_families.size(); ++i) {
@@ -1222,13 +1363,15 @@ private:
   NativeHandle handle = VK_NULL_HANDLE;
   Surface* surface = nullptr;
   VkPhysicalDeviceFeatures2 features;
+  bool timeline_semaphore_supported = false;
   VkPhysicalDeviceProperties2 properties;
 
   std::vector<VkLayerProperties> available_layers;
   std::vector<VkExtensionProperties> available_extensions;
   std::vector<VkQueueFamilyProperties2> available_queue_families;
   std::map<std::size_t, bool> surface_support_map;
-  VkSurfaceCapabilities2KHR surface_capabilities;
+  VkSurfaceCapabilities2KHR surface_capabilities{};
+  VkPhysicalDeviceMemoryProperties memory_properties{};
 
   std::vector<VkSurfaceFormat2KHR> surface_formats;
   std::vector<VkPresentModeKHR> present_modes;
@@ -1281,6 +1424,19 @@ public:
     return *this;
   }
 
+  // Filters out devices without timeline semaphores and enables the feature on the created device
+  PhysicalDeviceSelector& set_require_timeline_semaphore() {
+    require_timeline_semaphore = true;
+    device_create_info_builder.with_next(&timeline_semaphore_features);
+    return *this;
+  }
+
+  // Enables pipeline statistics queries on the created device when it supports them, devices without are still selected
+  PhysicalDeviceSelector& set_enable_pipeline_statistics() noexcept {
+    enable_pipeline_statistics = true;
+    return *this;
+  }
+
   PhysicalDeviceSelector& with_queue(const VkDeviceQueueCreateInfo& queue) noexcept {
     device_create_info_builder.with_queue(queue);
     return *this;
@@ -1325,9 +1481,15 @@ public:
   }
 
   Device create_device(const PhysicalDevice& physical_device) {
+    if (enable_pipeline_statistics and physical_device.has_pipeline_statistics_query())
+      device_create_info_builder.with_features(VkPhysicalDeviceFeatures{
+          .pipelineStatisticsQuery = VK_TRUE,
+          .inheritedQueries = VK_TRUE,
+      });
+
     auto device_create_info = device_create_info_builder.build();
     VkDevice device;
-    vkCreateDevice(physical_device, &device_create_info, nullptr, &device);
+    vkCreateDevice(physical_device, &device_create_info, helper::allocation_callbacks(), &device);
 
     std::call_once(device_initialize, [device]() { volkLoadDevice(device); });
     return Device{device};
@@ -1344,6 +1506,9 @@ private:
     if (require_preset_queue and not device.has_preset())
       return false;
 
+    if (require_timeline_semaphore and not device.has_timeline_semaphore())
+      return false;
+
     if (not device.has_extensions(required_gpu_extensions))
       return false;
 
@@ -1378,6 +1543,13 @@ private:
   std::vector<PhysicalDeviceType> allowed_gpu_types;
   bool require_preset_queue{true};
   bool require_graphic_queue{true};
+  bool require_timeline_semaphore{false};
+  bool enable_pipeline_statistics{false};
+  VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+      .pNext = nullptr,
+      .timelineSemaphore = VK_TRUE,
+  };
 
   DeviceCreateInfoBuilder device_create_info_builder;
   std::once_flag device_initialize;
@@ -1409,13 +1581,48 @@ public:
     if (handle == VK_NULL_HANDLE)
       return;
 
-    vkDestroySemaphore(*device, handle, nullptr);
+    vkDestroySemaphore(*device, handle, helper::allocation_callbacks());
   }
 
   operator const NativeHandle() const noexcept {
     return handle;
   }
 
+  // Timeline semaphores only: the last value the device (or the host) signaled
+  [[nodiscard]] uint64_t get_value() const noexcept {
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(*device, handle, &value);
+    return value;
+  }
+
+  // Timeline semaphores only: blocks until the counter reaches value, false on timeout
+  bool wait(uint64_t value, std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max()) const noexcept {
+    // clang-format off
+    const auto wait_info = VkSemaphoreWaitInfo{
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+      .pNext = nullptr,
+      .flags = 0,
+      .semaphoreCount = 1,
+      .pSemaphores = &handle,
+      .pValues = &value,
+    };
+    // clang-format on
+    return vkWaitSemaphores(*device, &wait_info, static_cast<uint64_t>(timeout.count())) == VK_SUCCESS;
+  }
+
+  // Timeline semaphores only: moves the counter forward from the host
+  void signal(uint64_t value) const noexcept {
+    // clang-format off
+    const auto signal_info = VkSemaphoreSignalInfo{
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO,
+      .pNext = nullptr,
+      .semaphore = handle,
+      .value = value,
+    };
+    // clang-format on
+    vkSignalSemaphore(*device, &signal_info);
+  }
+
 private:
   Semaphore(NativeHandle handle, Device* device) noexcept : handle{handle}, device{device} {}
 
@@ -1441,15 +1648,41 @@ public:
     return *this;
   }
 
+  SemaphoreBuilder& with_type(SemaphoreType type) noexcept {
+    type_create_info.semaphoreType = static_cast<VkSemaphoreType>(type);
+    return *this;
+  }
+
+  // Only meaningful for timeline semaphores
+  SemaphoreBuilder& with_initial_value(uint64_t value) noexcept {
+    type_create_info.initialValue = value;
+    return *this;
+  }
+
   Semaphore build() const noexcept {
+    auto create_info = semaphore_create_info;
+    auto type_info = type_create_info;
+    if (type_info.semaphoreType == VK_SEMAPHORE_TYPE_TIMELINE) {
+      type_info.pNext = create_info.pNext;
+      create_info.pNext = &type_info;
+    }
+
     VkSemaphore semaphore;
-    vkCreateSemaphore(device, &semaphore_create_info, nullptr, &semaphore);
+    vkCreateSemaphore(device, &create_info, helper::allocation_callbacks(), &semaphore);
     return Semaphore{semaphore, &device};
   }
 
 private:
   Device& device;
   VkSemaphoreCreateInfo semaphore_create_info;
+  // clang-format off
+  VkSemaphoreTypeCreateInfo type_create_info{
+    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+    .pNext = nullptr,
+    .semaphoreType = VK_SEMAPHORE_TYPE_BINARY,
+    .initialValue = 0,
+  };
+  // clang-format on
 };
 
 Fence::Fence(std::nullptr_t) noexcept : handle{VK_NULL_HANDLE}, device{nullptr} {}
@@ -1469,7 +1702,7 @@ Fence::~Fence() {
   if (handle == VK_NULL_HANDLE)
     return;
 
-  vkDestroyFence(*device, handle, nullptr);
+  vkDestroyFence(*device, handle, helper::allocation_callbacks());
 }
 
 void Fence::wait_for(std::chrono::nanoseconds timeout) const noexcept {
@@ -1486,6 +1719,10 @@ void Fence::reset() const noexcept {
   vkResetFences(*device, 1, &handle);
 }
 
+bool Fence::is_signaled() const noexcept {
+  return vkGetFenceStatus(*device, handle) == VK_SUCCESS;
+}
+
 class FenceBuilder {
 public:
   explicit FenceBuilder(Device& device) : device{device} {
@@ -1512,7 +1749,7 @@ public:
 
   Fence build() const noexcept {
     VkFence fence;
-    vkCreateFence(device, &fence_create_info, nullptr, &fence);
+    vkCreateFence(device, &fence_create_info, helper::allocation_callbacks(), &fence);
     return Fence{fence, &device};
   }
 
@@ -1521,202 +1758,506 @@ private:
   VkFenceCreateInfo fence_create_info;
 };
 
-class Image {
-  friend class Swapchain;
+using DeviceSize = VkDeviceSize;
+
+class DeviceMemory {
+  friend class DeviceMemoryBuilder;
 
 public:
-  using NativeHandle = VkImage;
+  using NativeHandle = VkDeviceMemory;
 
-  Image(std::nullptr_t) noexcept : device{nullptr}, handle{VK_NULL_HANDLE}, is_swapchain_image{false} {}
+  DeviceMemory(std::nullptr_t) noexcept : handle{VK_NULL_HANDLE}, device{nullptr} {}
 
-  Image(Image&) = delete;
-  Image& operator=(Image&) = delete;
+  DeviceMemory(const DeviceMemory&) = delete;
+  DeviceMemory& operator=(const DeviceMemory&) = delete;
 
-  Image(Image&& other) : device{other.device}, handle{other.handle}, is_swapchain_image{other.is_swapchain_image} {
-    other.device = nullptr;
+  DeviceMemory(DeviceMemory&& other) noexcept
+      : handle{other.handle}, device{other.device}, size{other.size}, mapped{other.mapped} {
     other.handle = VK_NULL_HANDLE;
+    other.device = nullptr;
+    other.size = 0;
+    other.mapped = nullptr;
   }
 
-  Image& operator=(Image&& other) noexcept {
-    std::swap(device, other.device);
+  DeviceMemory& operator=(DeviceMemory&& other) noexcept {
     std::swap(handle, other.handle);
-    std::swap(is_swapchain_image, other.is_swapchain_image);
+    std::swap(device, other.device);
+    std::swap(size, other.size);
+    std::swap(mapped, other.mapped);
     return *this;
   }
 
-  ~Image() {
-    if (handle == VK_NULL_HANDLE or is_swapchain_image)
+  ~DeviceMemory() {
+    if (handle == VK_NULL_HANDLE)
       return;
 
-    vkDestroyImage(*device, handle, nullptr);
+    unmap();
+    vkFreeMemory(*device, handle, helper::allocation_callbacks());
   }
 
   operator NativeHandle() const noexcept {
     return handle;
   }
 
-private:
-  Image(Device* device, NativeHandle handle, bool is_swaphcain)
-      : device{device}, handle{handle}, is_swapchain_image{is_swaphcain} {}
+  [[nodiscard]] DeviceSize get_size() const noexcept {
+    return size;
+  }
 
-private:
-  Device* device = nullptr;
-  NativeHandle handle = VK_NULL_HANDLE;
-  bool is_swapchain_image = false;
-};
+  // The memory stays mapped until unmap() is called or the memory is freed, so calling map() every frame is cheap
+  [[nodiscard]] std::span<std::byte> map() noexcept {
+    if (mapped == nullptr)
+      vkMapMemory(*device, handle, 0, VK_WHOLE_SIZE, 0, &mapped);
 
-class MemoryBarrier {
-  friend class MemoryBarrierBuilder;
+    return {static_cast<std::byte*>(mapped), static_cast<std::size_t>(size)};
+  }
 
-public:
-  using NativeType = VkMemoryBarrier;
+  void unmap() noexcept {
+    if (mapped == nullptr)
+      return;
 
-private:
-  explicit MemoryBarrier(NativeType native_type) : native_type{native_type} {}
+    vkUnmapMemory(*device, handle);
+    mapped = nullptr;
+  }
 
-  operator const NativeType&() const noexcept {
-    return native_type;
+  // Needed before reading device writes when the memory is not host coherent
+  void invalidate() const noexcept {
+    const auto range = mapped_range();
+    vkInvalidateMappedMemoryRanges(*device, 1, &range);
   }
 
-  operator const NativeType*() const noexcept {
-    return &native_type;
+  // Needed after host writes when the memory is not host coherent
+  void flush() const noexcept {
+    const auto range = mapped_range();
+    vkFlushMappedMemoryRanges(*device, 1, &range);
   }
 
 private:
-  VkMemoryBarrier native_type;
+  DeviceMemory(NativeHandle handle, Device* device, DeviceSize size) noexcept
+      : handle{handle}, device{device}, size{size} {}
+
+  VkMappedMemoryRange mapped_range() const noexcept {
+    return VkMappedMemoryRange{
+        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+        .pNext = nullptr,
+        .memory = handle,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+  }
+
+private:
+  NativeHandle handle = VK_NULL_HANDLE;
+  Device* device = nullptr;
+  DeviceSize size = 0;
+  void* mapped = nullptr;
 };
 
-class MemoryBarrierBuilder {
+class DeviceMemoryBuilder {
 public:
-  explicit MemoryBarrierBuilder() noexcept {
-    mem_barr = VkMemoryBarrier{
-        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
-        .pNext = nullptr,
-        .srcAccessMask = {},
-        .dstAccessMask = {},
+  DeviceMemoryBuilder(const PhysicalDevice& physical_device, Device& device)
+      : physical_device{physical_device}, device{device} {
+    // clang-format off
+    allocate_info = VkMemoryAllocateInfo{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .pNext = nullptr,
+      .allocationSize = 0,
+      .memoryTypeIndex = 0,
     };
+    // clang-format on
   }
 
-  MemoryBarrierBuilder& with_next(void* next) noexcept {
-    mem_barr.pNext = next;
+  DeviceMemoryBuilder& with_next(const void* next) noexcept {
+    allocate_info.pNext = next;
     return *this;
   }
 
-  MemoryBarrierBuilder& with_src_access_mask(AccessFlags src_access_mask) noexcept {
-    mem_barr.srcAccessMask = static_cast<AccessFlags::MaskType>(src_access_mask);
+  DeviceMemoryBuilder& with_requirements(const VkMemoryRequirements& memory_requirements) noexcept {
+    requirements = memory_requirements;
     return *this;
   }
 
-  MemoryBarrierBuilder& with_dst_access_mask(AccessFlags dst_access_mask) noexcept {
-    mem_barr.dstAccessMask = static_cast<AccessFlags::MaskType>(dst_access_mask);
+  DeviceMemoryBuilder& with_properties(MemoryPropertyFlags memory_properties) noexcept {
+    properties = memory_properties;
     return *this;
   }
 
+  DeviceMemory build() {
+    auto memory_type_index = physical_device.find_memory_type_index(requirements.memoryTypeBits, properties);
+    if (not memory_type_index)
+      throw std::runtime_error{"No memory type matches the requested properties"};
+
+    allocate_info.allocationSize = requirements.size;
+    allocate_info.memoryTypeIndex = *memory_type_index;
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(device, &allocate_info, helper::allocation_callbacks(), &memory) != VK_SUCCESS)
+      throw std::runtime_error{"Unable to allocate device memory"};
+
+    return DeviceMemory{memory, &device, requirements.size};
+  }
+
 private:
-  VkMemoryBarrier mem_barr;
+  const PhysicalDevice& physical_device;
+  Device& device;
+  VkMemoryAllocateInfo allocate_info;
+  VkMemoryRequirements requirements{};
+  MemoryPropertyFlags properties{};
 };
 
-class ImageMemoryBarrier {
-  friend class ImageMemoryBarrierBuilder;
+class Image {
+  friend class Swapchain;
+  friend class ImageBuilder;
 
 public:
-  using NativeType = VkImageMemoryBarrier;
+  using NativeHandle = VkImage;
 
-  operator const NativeType*() const noexcept {
-    return &image_memory_barrier;
-  }
+  Image(std::nullptr_t) noexcept : device{nullptr}, handle{VK_NULL_HANDLE}, is_swapchain_image{false} {}
 
-private:
-  explicit ImageMemoryBarrier(NativeType image_memory_barrier) : image_memory_barrier{image_memory_barrier} {}
+  Image(Image&) = delete;
+  Image& operator=(Image&) = delete;
 
-private:
-  NativeType image_memory_barrier;
-};
+  Image(Image&& other) : device{other.device}, handle{other.handle}, is_swapchain_image{other.is_swapchain_image} {
+    other.device = nullptr;
+    other.handle = VK_NULL_HANDLE;
+  }
 
-using DeviceSize = VkDeviceSize;
+  Image& operator=(Image&& other) noexcept {
+    std::swap(device, other.device);
+    std::swap(handle, other.handle);
+    std::swap(is_swapchain_image, other.is_swapchain_image);
+    return *this;
+  }
 
-class ImageSubresourceRange {
-  friend class ImageSubresourceRangeBuilder;
+  ~Image() {
+    if (handle == VK_NULL_HANDLE or is_swapchain_image)
+      return;
 
-public:
-  using NativeType = VkImageSubresourceRange;
+    vkDestroyImage(*device, handle, helper::allocation_callbacks());
+  }
 
-  operator const NativeType&() const noexcept {
-    return native_type;
+  operator NativeHandle() const noexcept {
+    return handle;
   }
 
-  operator const NativeType*() const noexcept {
-    return &native_type;
+  [[nodiscard]] VkMemoryRequirements get_memory_requirements() const noexcept {
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(*device, handle, &requirements);
+    return requirements;
+  }
+
+  void bind_memory(const DeviceMemory& memory, DeviceSize offset = 0) const noexcept {
+    vkBindImageMemory(*device, handle, memory, offset);
   }
 
 private:
-  explicit ImageSubresourceRange(VkImageSubresourceRange native) : native_type{native} {}
+  Image(Device* device, NativeHandle handle, bool is_swaphcain)
+      : device{device}, handle{handle}, is_swapchain_image{is_swaphcain} {}
 
 private:
-  NativeType native_type;
+  Device* device = nullptr;
+  NativeHandle handle = VK_NULL_HANDLE;
+  bool is_swapchain_image = false;
 };
 
-class ImageSubresourceRangeBuilder {
-  friend class ImageSubresourceRangeBuilder;
-
+class ImageBuilder {
 public:
-  using NativeHandle = VkImageSubresourceRange;
-
-  ImageSubresourceRangeBuilder() {
+  explicit ImageBuilder(Device& device) : device{device} {
     // clang-format off
-    sub_range = VkImageSubresourceRange{
-      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-      .baseMipLevel = 0,
-      .levelCount = 1,
-      .baseArrayLayer = 0,
-      .layerCount = 1,
+    image_create_info = VkImageCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .imageType = VK_IMAGE_TYPE_2D,
+      .format = VK_FORMAT_R8G8B8A8_UNORM,
+      .extent = VkExtent3D{1, 1, 1},
+      .mipLevels = 1,
+      .arrayLayers = 1,
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .tiling = VK_IMAGE_TILING_OPTIMAL,
+      .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+      .queueFamilyIndexCount = 0,
+      .pQueueFamilyIndices = nullptr,
+      .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
     };
     // clang-format on
   }
 
-  ImageSubresourceRangeBuilder& with_aspect_mask(ImageAspectFlags aspect_mask) {
-    sub_range.aspectMask = static_cast<ImageAspectFlags::MaskType>(aspect_mask);
+  ImageBuilder& with_next(const void* next) noexcept {
+    image_create_info.pNext = next;
     return *this;
   }
 
-  ImageSubresourceRangeBuilder& with_base_mip_level(int base_mip_level) {
-    sub_range.baseMipLevel = static_cast<uint32_t>(base_mip_level);
+  ImageBuilder& with_format(Format format) noexcept {
+    image_create_info.format = static_cast<VkFormat>(format);
     return *this;
   }
 
-  ImageSubresourceRangeBuilder& with_level_count(int level_count) {
-    sub_range.levelCount = static_cast<uint32_t>(level_count);
+  ImageBuilder& with_extent(int width, int height) noexcept {
+    image_create_info.extent = VkExtent3D{static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
     return *this;
   }
 
-  ImageSubresourceRangeBuilder& with_base_array_layer(int base_array_layer) {
-    sub_range.baseArrayLayer = static_cast<uint32_t>(base_array_layer);
+  ImageBuilder& with_usage(ImageUsageFlags usage) noexcept {
+    image_create_info.usage = static_cast<ImageUsageFlags::MaskType>(usage);
     return *this;
   }
 
-  ImageSubresourceRangeBuilder& with_layer_count(int layer_count) {
-    sub_range.layerCount = static_cast<uint32_t>(layer_count);
+  ImageBuilder& with_tiling(ImageTiling tiling) noexcept {
+    image_create_info.tiling = static_cast<VkImageTiling>(tiling);
     return *this;
   }
 
-  ImageSubresourceRange build() const noexcept {
-    return ImageSubresourceRange{sub_range};
+  Image build() const {
+    VkImage image;
+    if (vkCreateImage(device, &image_create_info, helper::allocation_callbacks(), &image) != VK_SUCCESS)
+      throw std::runtime_error{"Unable to create the image"};
+
+    return Image{&device, image, false};
   }
 
 private:
-  VkImageSubresourceRange sub_range;
+  Device& device;
+  VkImageCreateInfo image_create_info;
 };
 
-class ImageMemoryBarrierBuilder {
+class ImageView {
+  friend class ImageViewBuilder;
+
 public:
-  ImageMemoryBarrierBuilder() noexcept {
-    image_memory_barrier = VkImageMemoryBarrier{
-        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-        .pNext = nullptr,
-        .srcAccessMask = {},
-        .dstAccessMask = {},
-        .oldLayout = {},
-        .newLayout = {},
+  using NativeHandle = VkImageView;
+
+  ImageView(std::nullptr_t) noexcept : handle{VK_NULL_HANDLE}, device{nullptr} {}
+
+  ImageView(const ImageView&) = delete;
+  ImageView& operator=(const ImageView&) = delete;
+
+  ImageView(ImageView&& other) noexcept : handle{other.handle}, device{other.device} {
+    other.handle = VK_NULL_HANDLE;
+    other.device = nullptr;
+  }
+
+  ImageView& operator=(ImageView&& other) noexcept {
+    std::swap(handle, other.handle);
+    std::swap(device, other.device);
+    return *this;
+  }
+
+  ~ImageView() {
+    if (handle == VK_NULL_HANDLE)
+      return;
+
+    vkDestroyImageView(*device, handle, helper::allocation_callbacks());
+  }
+
+  operator NativeHandle() const noexcept {
+    return handle;
+  }
+
+private:
+  ImageView(NativeHandle handle, Device* device) noexcept : handle{handle}, device{device} {}
+
+private:
+  NativeHandle handle = VK_NULL_HANDLE;
+  Device* device = nullptr;
+};
+
+// Builds a 2D view over the first mip level and layer of a color image
+class ImageViewBuilder {
+public:
+  ImageViewBuilder(Device& device, const Image& image) : device{device} {
+    // clang-format off
+    image_view_create_info = VkImageViewCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .image = image,
+      .viewType = VK_IMAGE_VIEW_TYPE_2D,
+      .format = VK_FORMAT_R8G8B8A8_UNORM,
+      .components = VkComponentMapping{},
+      .subresourceRange = VkImageSubresourceRange{
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = 0,
+        .levelCount = 1,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+      },
+    };
+    // clang-format on
+  }
+
+  ImageViewBuilder& with_format(Format format) noexcept {
+    image_view_create_info.format = static_cast<VkFormat>(format);
+    return *this;
+  }
+
+  ImageView build() const {
+    VkImageView image_view;
+    if (vkCreateImageView(device, &image_view_create_info, helper::allocation_callbacks(), &image_view) != VK_SUCCESS)
+      throw std::runtime_error{"Unable to create the image view"};
+
+    return ImageView{image_view, &device};
+  }
+
+private:
+  Device& device;
+  VkImageViewCreateInfo image_view_create_info;
+};
+
+class MemoryBarrier {
+  friend class MemoryBarrierBuilder;
+
+public:
+  using NativeType = VkMemoryBarrier;
+
+  operator const NativeType&() const noexcept {
+    return native_type;
+  }
+
+  operator const NativeType*() const noexcept {
+    return &native_type;
+  }
+
+private:
+  explicit MemoryBarrier(NativeType native_type) : native_type{native_type} {}
+
+private:
+  VkMemoryBarrier native_type;
+};
+
+class MemoryBarrierBuilder {
+public:
+  explicit MemoryBarrierBuilder() noexcept {
+    mem_barr = VkMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = {},
+        .dstAccessMask = {},
+    };
+  }
+
+  MemoryBarrierBuilder& with_next(void* next) noexcept {
+    mem_barr.pNext = next;
+    return *this;
+  }
+
+  MemoryBarrierBuilder& with_src_access_mask(AccessFlags src_access_mask) noexcept {
+    mem_barr.srcAccessMask = static_cast<AccessFlags::MaskType>(src_access_mask);
+    return *this;
+  }
+
+  MemoryBarrierBuilder& with_dst_access_mask(AccessFlags dst_access_mask) noexcept {
+    mem_barr.dstAccessMask = static_cast<AccessFlags::MaskType>(dst_access_mask);
+    return *this;
+  }
+
+  MemoryBarrier build() const noexcept {
+    return MemoryBarrier{mem_barr};
+  }
+
+private:
+  VkMemoryBarrier mem_barr;
+};
+
+class ImageMemoryBarrier {
+  friend class ImageMemoryBarrierBuilder;
+
+public:
+  using NativeType = VkImageMemoryBarrier;
+
+  operator const NativeType*() const noexcept {
+    return &image_memory_barrier;
+  }
+
+private:
+  explicit ImageMemoryBarrier(NativeType image_memory_barrier) : image_memory_barrier{image_memory_barrier} {}
+
+private:
+  NativeType image_memory_barrier;
+};
+
+class ImageSubresourceRange {
+  friend class ImageSubresourceRangeBuilder;
+
+public:
+  using NativeType = VkImageSubresourceRange;
+
+  operator const NativeType&() const noexcept {
+    return native_type;
+  }
+
+  operator const NativeType*() const noexcept {
+    return &native_type;
+  }
+
+private:
+  explicit ImageSubresourceRange(VkImageSubresourceRange native) : native_type{native} {}
+
+private:
+  NativeType native_type;
+};
+
+class ImageSubresourceRangeBuilder {
+  friend class ImageSubresourceRangeBuilder;
+
+public:
+  using NativeHandle = VkImageSubresourceRange;
+
+  ImageSubresourceRangeBuilder() {
+    // clang-format off
+    sub_range = VkImageSubresourceRange{
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .baseMipLevel = 0,
+      .levelCount = 1,
+      .baseArrayLayer = 0,
+      .layerCount = 1,
+    };
+    // clang-format on
+  }
+
+  ImageSubresourceRangeBuilder& with_aspect_mask(ImageAspectFlags aspect_mask) {
+    sub_range.aspectMask = static_cast<ImageAspectFlags::MaskType>(aspect_mask);
+    return *this;
+  }
+
+  ImageSubresourceRangeBuilder& with_base_mip_level(int base_mip_level) {
+    sub_range.baseMipLevel = static_cast<uint32_t>(base_mip_level);
+    return *this;
+  }
+
+  ImageSubresourceRangeBuilder& with_level_count(int level_count) {
+    sub_range.levelCount = static_cast<uint32_t>(level_count);
+    return *this;
+  }
+
+  ImageSubresourceRangeBuilder& with_base_array_layer(int base_array_layer) {
+    sub_range.baseArrayLayer = static_cast<uint32_t>(base_array_layer);
+    return *this;
+  }
+
+  ImageSubresourceRangeBuilder& with_layer_count(int layer_count) {
+    sub_range.layerCount = static_cast<uint32_t>(layer_count);
+    return *this;
+  }
+
+  ImageSubresourceRange build() const noexcept {
+    return ImageSubresourceRange{sub_range};
+  }
+
+private:
+  VkImageSubresourceRange sub_range;
+};
+
+class ImageMemoryBarrierBuilder {
+public:
+  ImageMemoryBarrierBuilder() noexcept {
+    image_memory_barrier = VkImageMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = {},
+        .dstAccessMask = {},
+        .oldLayout = {},
+        .newLayout = {},
         .srcQueueFamilyIndex = {},
         .dstQueueFamilyIndex = {},
         .image = VK_NULL_HANDLE,
@@ -1835,7 +2376,7 @@ public:
     if (handle == VK_NULL_HANDLE)
       return;
 
-    vkDestroySwapchainKHR(*device, handle, nullptr);
+    vkDestroySwapchainKHR(*device, handle, helper::allocation_callbacks());
   }
 
   operator NativeHandle() const noexcept {
@@ -1879,7 +2420,8 @@ public:
         vkAcquireNextImage2KHR(static_cast<Device::NativeHandle>(*device),
                                static_cast<const AcquireNextImageInfoKHR::NativeType*>(acquire_info), &image_index);
 
-    if (res != VK_SUCCESS)
+    // a suboptimal swapchain still hands out a usable image and signals the semaphore, so it has to be presented
+    if (res != VK_SUCCESS and res != VK_SUBOPTIMAL_KHR)
       return std::unexpected{AcquireImageError{res}};
 
     return image_index;
@@ -1951,99 +2493,675 @@ public:
     return *this;
   }
 
-  SwapchainBuilder& with_usage(ImageUsageFlags required_image_usage) {
-    swapchain_create_info.imageUsage = static_cast<ImageUsageFlags::MaskType>(required_image_usage);
-    return *this;
-  }
+  SwapchainBuilder& with_usage(ImageUsageFlags required_image_usage) {
+    swapchain_create_info.imageUsage = static_cast<ImageUsageFlags::MaskType>(required_image_usage);
+    return *this;
+  }
+
+  SwapchainBuilder& with_queue_family_indexes(std::span<uint32_t> indexes) {
+    swapchain_create_info.queueFamilyIndexCount = static_cast<uint32_t>(indexes.size());
+    swapchain_create_info.pQueueFamilyIndices = indexes.data();
+    return *this;
+  }
+
+  SwapchainBuilder& with_old_swapchain(Swapchain& old_swapchain) {
+    swapchain_create_info.oldSwapchain = static_cast<Swapchain::NativeHandle>(old_swapchain);
+    return *this;
+  }
+
+  Swapchain build() {
+
+    VkSwapchainKHR swapchain;
+    vkCreateSwapchainKHR(device, &swapchain_create_info, helper::allocation_callbacks(), &swapchain);
+    return Swapchain{swapchain, &device};
+  }
+
+private:
+  Device& device;
+  VkSwapchainCreateInfoKHR swapchain_create_info;
+};
+
+class AcquireNextImageInfoKHRBuilder {
+public:
+  AcquireNextImageInfoKHRBuilder(const Swapchain& swapchain) {
+    native = VkAcquireNextImageInfoKHR{};
+    native.sType = VK_STRUCTURE_TYPE_ACQUIRE_NEXT_IMAGE_INFO_KHR;
+    native.swapchain = static_cast<Swapchain::NativeHandle>(swapchain);
+    native.timeout = std::numeric_limits<uint64_t>::max();
+    native.deviceMask = 1;
+  }
+
+  AcquireNextImageInfoKHRBuilder& with_next(void* next) noexcept {
+    native.pNext = next;
+    return *this;
+  }
+
+  AcquireNextImageInfoKHRBuilder& with_semaphore(const Semaphore& semaphore) noexcept {
+    native.semaphore = static_cast<Semaphore::NativeHandle>(semaphore);
+    return *this;
+  }
+
+  AcquireNextImageInfoKHRBuilder& with_timeout(std::chrono::nanoseconds timeout) noexcept {
+    native.timeout = static_cast<uint64_t>(timeout.count());
+    return *this;
+  }
+
+  AcquireNextImageInfoKHRBuilder& with_fence(const Fence& fence) noexcept {
+    native.fence = fence;
+    return *this;
+  }
+
+  AcquireNextImageInfoKHR build() {
+    return AcquireNextImageInfoKHR{native};
+  }
+
+private:
+  VkAcquireNextImageInfoKHR native;
+};
+
+class CommandPool {
+  friend class CommandPoolBuilder;
+
+public:
+  using NativeHandle = VkCommandPool;
+
+  CommandPool(std::nullptr_t) : handle{VK_NULL_HANDLE}, device{nullptr} {}
+
+  CommandPool(const CommandPool&) = delete;
+  CommandPool& operator=(const CommandPool&) = delete;
+
+  CommandPool(CommandPool&& other) noexcept : handle{other.handle}, device{other.device} {
+    other.handle = VK_NULL_HANDLE;
+    other.device = nullptr;
+  }
+
+  CommandPool& operator=(CommandPool&& other) noexcept {
+    std::swap(handle, other.handle);
+    std::swap(device, other.device);
+    return *this;
+  }
+
+  ~CommandPool() {
+    if (handle == VK_NULL_HANDLE)
+      return;
+
+    vkDestroyCommandPool(*device, handle, helper::allocation_callbacks());
+  }
+
+  operator NativeHandle() const noexcept {
+    return handle;
+  }
+
+  // Recycles every command buffer allocated from the pool at once, cheaper than resetting them one by one
+  void reset() const noexcept {
+    vkResetCommandPool(*device, handle, 0);
+  }
+
+private:
+  CommandPool(NativeHandle handle, Device* device) : handle{handle}, device{device} {}
+
+private:
+  NativeHandle handle = VK_NULL_HANDLE;
+  Device* device = nullptr;
+};
+
+class CommandPoolBuilder {
+public:
+  explicit CommandPoolBuilder(Device& device) : device{device} {
+    // clang-format off
+    command_pool_create_info = VkCommandPoolCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+      .queueFamilyIndex = {},
+    };
+    // clang-format on
+  }
+
+  CommandPoolBuilder& with_next(void* next) {
+    command_pool_create_info.pNext = next;
+    return *this;
+  }
+
+  CommandPoolBuilder& with_queue_family_index(std::size_t index) {
+    command_pool_create_info.queueFamilyIndex = static_cast<uint32_t>(index);
+    return *this;
+  }
+
+  CommandPoolBuilder& with_flags(CommandPoolCreateFlags required_flags) {
+    command_pool_create_info.flags = static_cast<VkCommandPoolCreateFlags>(required_flags);
+    return *this;
+  }
+
+  CommandPool build() const noexcept {
+    VkCommandPool command_pool;
+    vkCreateCommandPool(device, &command_pool_create_info, helper::allocation_callbacks(), &command_pool);
+
+    return CommandPool{command_pool, &device};
+  }
+
+private:
+  VkCommandPoolCreateInfo command_pool_create_info;
+  Device& device;
+};
+
+class QueryPool {
+  friend class QueryPoolBuilder;
+
+public:
+  using NativeHandle = VkQueryPool;
+
+  QueryPool(std::nullptr_t) noexcept : handle{VK_NULL_HANDLE}, device{nullptr} {}
+
+  QueryPool(const QueryPool&) = delete;
+  QueryPool& operator=(const QueryPool&) = delete;
+
+  QueryPool(QueryPool&& other) noexcept
+      : handle{other.handle}, device{other.device}, type{other.type}, query_count{other.query_count},
+        statistics{other.statistics} {
+    other.handle = VK_NULL_HANDLE;
+    other.device = nullptr;
+  }
+
+  QueryPool& operator=(QueryPool&& other) noexcept {
+    std::swap(handle, other.handle);
+    std::swap(device, other.device);
+    std::swap(type, other.type);
+    std::swap(query_count, other.query_count);
+    std::swap(statistics, other.statistics);
+    return *this;
+  }
+
+  ~QueryPool() {
+    if (handle == VK_NULL_HANDLE)
+      return;
+
+    vkDestroyQueryPool(*device, handle, helper::allocation_callbacks());
+  }
+
+  operator NativeHandle() const noexcept {
+    return handle;
+  }
+
+  [[nodiscard]] QueryType get_type() const noexcept {
+    return type;
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept {
+    return query_count;
+  }
+
+  // Number of 64 bit values every query writes, before the availability value
+  [[nodiscard]] std::size_t values_per_query() const noexcept {
+    if (type != QueryType::pipeline_statistics)
+      return 1;
+
+    return static_cast<std::size_t>(std::popcount(static_cast<QueryPipelineStatisticFlags::MaskType>(statistics)));
+  }
+
+  // Copies 64 bit results of [first, first + count) into results, values_per_query() values per query followed by the
+  // availability value. Without QueryResultFlagBits::wait_bit it never blocks and returns false when a query is not
+  // ready, in that case the available ones are still written with their availability value set.
+  bool get_results(std::size_t first, std::size_t count, std::span<uint64_t> results,
+                   QueryResultFlags flags = QueryResultFlagBits::with_availability_bit) const noexcept {
+    flags |= QueryResultFlagBits::result_64_bit;
+    const auto stride = (values_per_query() + 1) * sizeof(uint64_t);
+    assert(results.size_bytes() >= count * stride && "The results are too small for the requested queries");
+
+    return vkGetQueryPoolResults(*device, handle, static_cast<uint32_t>(first), static_cast<uint32_t>(count),
+                                 results.size_bytes(), results.data(), stride,
+                                 static_cast<VkQueryResultFlags>(flags)) == VK_SUCCESS;
+  }
+
+private:
+  QueryPool(NativeHandle handle, Device* device, QueryType type, std::size_t query_count,
+            QueryPipelineStatisticFlags statistics) noexcept
+      : handle{handle}, device{device}, type{type}, query_count{query_count}, statistics{statistics} {}
+
+private:
+  NativeHandle handle = VK_NULL_HANDLE;
+  Device* device = nullptr;
+  QueryType type = QueryType::timestamp;
+  std::size_t query_count = 0;
+  QueryPipelineStatisticFlags statistics{};
+};
+
+class QueryPoolBuilder {
+public:
+  explicit QueryPoolBuilder(Device& device) noexcept : device{device} {}
+
+  QueryPoolBuilder& with_type(QueryType query_type) noexcept {
+    type = query_type;
+    return *this;
+  }
+
+  QueryPoolBuilder& with_query_count(std::size_t count) noexcept {
+    query_count = count;
+    return *this;
+  }
+
+  // Only used by QueryType::pipeline_statistics pools
+  QueryPoolBuilder& with_pipeline_statistics(QueryPipelineStatisticFlags pipeline_statistics) noexcept {
+    statistics = pipeline_statistics;
+    return *this;
+  }
+
+  QueryPool build() const {
+    const auto is_statistics = type == QueryType::pipeline_statistics;
+
+    // clang-format off
+    const auto create_info = VkQueryPoolCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .queryType = static_cast<VkQueryType>(type),
+      .queryCount = static_cast<uint32_t>(query_count),
+      .pipelineStatistics = is_statistics ? static_cast<VkQueryPipelineStatisticFlags>(statistics) : 0,
+    };
+    // clang-format on
+
+    VkQueryPool query_pool;
+    if (vkCreateQueryPool(device, &create_info, helper::allocation_callbacks(), &query_pool) != VK_SUCCESS)
+      throw std::runtime_error{"Unable to create the query pool"};
+
+    return QueryPool{query_pool, &device, type, query_count,
+                     is_statistics ? statistics : QueryPipelineStatisticFlags{}};
+  }
+
+private:
+  Device& device;
+  QueryType type = QueryType::timestamp;
+  std::size_t query_count = 1;
+  QueryPipelineStatisticFlags statistics{};
+};
+
+class RenderPass {
+  friend class RenderPassBuilder;
+
+public:
+  using NativeHandle = VkRenderPass;
+
+  RenderPass(std::nullptr_t) noexcept : handle{VK_NULL_HANDLE}, device{nullptr} {}
+
+  RenderPass(const RenderPass&) = delete;
+  RenderPass& operator=(const RenderPass&) = delete;
+
+  RenderPass(RenderPass&& other) noexcept : handle{other.handle}, device{other.device} {
+    other.handle = VK_NULL_HANDLE;
+    other.device = nullptr;
+  }
+
+  RenderPass& operator=(RenderPass&& other) noexcept {
+    std::swap(handle, other.handle);
+    std::swap(device, other.device);
+    return *this;
+  }
+
+  ~RenderPass() {
+    if (handle == VK_NULL_HANDLE)
+      return;
+
+    vkDestroyRenderPass(*device, handle, helper::allocation_callbacks());
+  }
+
+  operator NativeHandle() const noexcept {
+    return handle;
+  }
+
+private:
+  RenderPass(NativeHandle handle, Device* device) noexcept : handle{handle}, device{device} {}
+
+private:
+  NativeHandle handle = VK_NULL_HANDLE;
+  Device* device = nullptr;
+};
+
+// A single subpass writing every color attachment, enough for 2D rendering
+class RenderPassBuilder {
+public:
+  explicit RenderPassBuilder(Device& device) noexcept : device{device} {}
+
+  RenderPassBuilder& with_color_attachment(Format format, AttachmentLoadOp load_op, AttachmentStoreOp store_op,
+                                           ImageLayout initial_layout, ImageLayout final_layout) {
+    // clang-format off
+    attachments.push_back(VkAttachmentDescription{
+      .flags = {},
+      .format = static_cast<VkFormat>(format),
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .loadOp = static_cast<VkAttachmentLoadOp>(load_op),
+      .storeOp = static_cast<VkAttachmentStoreOp>(store_op),
+      .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      .initialLayout = static_cast<VkImageLayout>(initial_layout),
+      .finalLayout = static_cast<VkImageLayout>(final_layout),
+    });
+    // clang-format on
+    return *this;
+  }
+
+  RenderPass build() const {
+    const auto color_references = std::views::iota(0u, static_cast<uint32_t>(attachments.size())) |
+                                  std::views::transform([](uint32_t index) {
+                                    return VkAttachmentReference{index, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+                                  }) |
+                                  std::ranges::to<std::vector<VkAttachmentReference>>();
+
+    // clang-format off
+    const auto subpass = VkSubpassDescription{
+      .flags = {},
+      .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+      .inputAttachmentCount = 0,
+      .pInputAttachments = nullptr,
+      .colorAttachmentCount = static_cast<uint32_t>(color_references.size()),
+      .pColorAttachments = color_references.data(),
+      .pResolveAttachments = nullptr,
+      .pDepthStencilAttachment = nullptr,
+      .preserveAttachmentCount = 0,
+      .pPreserveAttachments = nullptr,
+    };
+
+    // the layout transition waits for the stage the acquire semaphore is waited at
+    const auto dependency = VkSubpassDependency{
+      .srcSubpass = VK_SUBPASS_EXTERNAL,
+      .dstSubpass = 0,
+      .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      .srcAccessMask = 0,
+      .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+      .dependencyFlags = {},
+    };
+
+    const auto create_info = VkRenderPassCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .attachmentCount = static_cast<uint32_t>(attachments.size()),
+      .pAttachments = attachments.data(),
+      .subpassCount = 1,
+      .pSubpasses = &subpass,
+      .dependencyCount = 1,
+      .pDependencies = &dependency,
+    };
+    // clang-format on
+
+    VkRenderPass render_pass;
+    if (vkCreateRenderPass(device, &create_info, helper::allocation_callbacks(), &render_pass) != VK_SUCCESS)
+      throw std::runtime_error{"Unable to create the render pass"};
+
+    return RenderPass{render_pass, &device};
+  }
+
+private:
+  Device& device;
+  std::vector<VkAttachmentDescription> attachments;
+};
+
+class Framebuffer {
+  friend class FramebufferBuilder;
+
+public:
+  using NativeHandle = VkFramebuffer;
+
+  Framebuffer(std::nullptr_t) noexcept : handle{VK_NULL_HANDLE}, device{nullptr} {}
+
+  Framebuffer(const Framebuffer&) = delete;
+  Framebuffer& operator=(const Framebuffer&) = delete;
+
+  Framebuffer(Framebuffer&& other) noexcept : handle{other.handle}, device{other.device} {
+    other.handle = VK_NULL_HANDLE;
+    other.device = nullptr;
+  }
+
+  Framebuffer& operator=(Framebuffer&& other) noexcept {
+    std::swap(handle, other.handle);
+    std::swap(device, other.device);
+    return *this;
+  }
+
+  ~Framebuffer() {
+    if (handle == VK_NULL_HANDLE)
+      return;
+
+    vkDestroyFramebuffer(*device, handle, helper::allocation_callbacks());
+  }
+
+  operator NativeHandle() const noexcept {
+    return handle;
+  }
+
+private:
+  Framebuffer(NativeHandle handle, Device* device) noexcept : handle{handle}, device{device} {}
+
+private:
+  NativeHandle handle = VK_NULL_HANDLE;
+  Device* device = nullptr;
+};
+
+class FramebufferBuilder {
+public:
+  FramebufferBuilder(Device& device, const RenderPass& render_pass) : device{device}, render_pass{render_pass} {}
+
+  FramebufferBuilder& with_attachment(const ImageView& image_view) {
+    attachments.push_back(image_view);
+    return *this;
+  }
+
+  FramebufferBuilder& with_extent(int framebuffer_width, int framebuffer_height) noexcept {
+    width = static_cast<uint32_t>(framebuffer_width);
+    height = static_cast<uint32_t>(framebuffer_height);
+    return *this;
+  }
+
+  Framebuffer build() const {
+    // clang-format off
+    const auto create_info = VkFramebufferCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .renderPass = render_pass,
+      .attachmentCount = static_cast<uint32_t>(attachments.size()),
+      .pAttachments = attachments.data(),
+      .width = width,
+      .height = height,
+      .layers = 1,
+    };
+    // clang-format on
+
+    VkFramebuffer framebuffer;
+    if (vkCreateFramebuffer(device, &create_info, helper::allocation_callbacks(), &framebuffer) != VK_SUCCESS)
+      throw std::runtime_error{"Unable to create the framebuffer"};
+
+    return Framebuffer{framebuffer, &device};
+  }
+
+private:
+  Device& device;
+  const RenderPass& render_pass;
+  std::vector<VkImageView> attachments;
+  uint32_t width = 1;
+  uint32_t height = 1;
+};
+
+class ShaderModule {
+  friend class ShaderModuleBuilder;
+
+public:
+  using NativeHandle = VkShaderModule;
+
+  ShaderModule(std::nullptr_t) noexcept : handle{VK_NULL_HANDLE}, device{nullptr} {}
+
+  ShaderModule(const ShaderModule&) = delete;
+  ShaderModule& operator=(const ShaderModule&) = delete;
+
+  ShaderModule(ShaderModule&& other) noexcept : handle{other.handle}, device{other.device} {
+    other.handle = VK_NULL_HANDLE;
+    other.device = nullptr;
+  }
+
+  ShaderModule& operator=(ShaderModule&& other) noexcept {
+    std::swap(handle, other.handle);
+    std::swap(device, other.device);
+    return *this;
+  }
+
+  ~ShaderModule() {
+    if (handle == VK_NULL_HANDLE)
+      return;
+
+    vkDestroyShaderModule(*device, handle, helper::allocation_callbacks());
+  }
+
+  operator NativeHandle() const noexcept {
+    return handle;
+  }
+
+private:
+  ShaderModule(NativeHandle handle, Device* device) noexcept : handle{handle}, device{device} {}
+
+private:
+  NativeHandle handle = VK_NULL_HANDLE;
+  Device* device = nullptr;
+};
+
+class ShaderModuleBuilder {
+public:
+  explicit ShaderModuleBuilder(Device& device) noexcept : device{device} {}
 
-  SwapchainBuilder& with_queue_family_indexes(std::span<uint32_t> indexes) {
-    swapchain_create_info.queueFamilyIndexCount = static_cast<uint32_t>(indexes.size());
-    swapchain_create_info.pQueueFamilyIndices = indexes.data();
+  // SPIR-V words, the module keeps no reference to them
+  ShaderModuleBuilder& with_code(std::span<const uint32_t> spirv) noexcept {
+    code = spirv;
     return *this;
   }
 
-  SwapchainBuilder& with_old_swapchain(Swapchain& old_swapchain) {
-    swapchain_create_info.oldSwapchain = static_cast<Swapchain::NativeHandle>(old_swapchain);
-    return *this;
-  }
+  ShaderModule build() const {
+    // clang-format off
+    const auto create_info = VkShaderModuleCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .codeSize = code.size_bytes(),
+      .pCode = code.data(),
+    };
+    // clang-format on
 
-  Swapchain build() {
+    VkShaderModule shader_module;
+    if (vkCreateShaderModule(device, &create_info, helper::allocation_callbacks(), &shader_module) != VK_SUCCESS)
+      throw std::runtime_error{"Unable to create the shader module"};
 
-    VkSwapchainKHR swapchain;
-    vkCreateSwapchainKHR(device, &swapchain_create_info, nullptr, &swapchain);
-    return Swapchain{swapchain, &device};
+    return ShaderModule{shader_module, &device};
   }
 
 private:
   Device& device;
-  VkSwapchainCreateInfoKHR swapchain_create_info;
+  std::span<const uint32_t> code;
 };
 
-class AcquireNextImageInfoKHRBuilder {
+class PipelineLayout {
+  friend class PipelineLayoutBuilder;
+
 public:
-  AcquireNextImageInfoKHRBuilder(const Swapchain& swapchain) {
-    native = VkAcquireNextImageInfoKHR{};
-    native.sType = VK_STRUCTURE_TYPE_ACQUIRE_NEXT_IMAGE_INFO_KHR;
-    native.swapchain = static_cast<Swapchain::NativeHandle>(swapchain);
-    native.timeout = std::numeric_limits<uint64_t>::max();
-    native.deviceMask = 1;
+  using NativeHandle = VkPipelineLayout;
+
+  PipelineLayout(std::nullptr_t) noexcept : handle{VK_NULL_HANDLE}, device{nullptr} {}
+
+  PipelineLayout(const PipelineLayout&) = delete;
+  PipelineLayout& operator=(const PipelineLayout&) = delete;
+
+  PipelineLayout(PipelineLayout&& other) noexcept : handle{other.handle}, device{other.device} {
+    other.handle = VK_NULL_HANDLE;
+    other.device = nullptr;
   }
 
-  AcquireNextImageInfoKHRBuilder& with_next(void* next) noexcept {
-    native.pNext = next;
+  PipelineLayout& operator=(PipelineLayout&& other) noexcept {
+    std::swap(handle, other.handle);
+    std::swap(device, other.device);
     return *this;
   }
 
-  AcquireNextImageInfoKHRBuilder& with_semaphore(const Semaphore& semaphore) noexcept {
-    native.semaphore = static_cast<Semaphore::NativeHandle>(semaphore);
-    return *this;
+  ~PipelineLayout() {
+    if (handle == VK_NULL_HANDLE)
+      return;
+
+    vkDestroyPipelineLayout(*device, handle, helper::allocation_callbacks());
   }
 
-  AcquireNextImageInfoKHRBuilder& with_timeout(std::chrono::nanoseconds timeout) noexcept {
-    native.timeout = static_cast<uint64_t>(timeout.count());
-    return *this;
+  operator NativeHandle() const noexcept {
+    return handle;
   }
 
-  AcquireNextImageInfoKHRBuilder& with_fence(const Fence& fence) noexcept {
-    native.fence = fence;
+private:
+  PipelineLayout(NativeHandle handle, Device* device) noexcept : handle{handle}, device{device} {}
+
+private:
+  NativeHandle handle = VK_NULL_HANDLE;
+  Device* device = nullptr;
+};
+
+class PipelineLayoutBuilder {
+public:
+  explicit PipelineLayoutBuilder(Device& device) noexcept : device{device} {}
+
+  PipelineLayoutBuilder& with_push_constant_range(ShaderStageFlags stages, std::size_t offset, std::size_t size) {
+    push_constant_ranges.push_back(VkPushConstantRange{
+        .stageFlags = static_cast<VkShaderStageFlags>(stages),
+        .offset = static_cast<uint32_t>(offset),
+        .size = static_cast<uint32_t>(size),
+    });
     return *this;
   }
 
-  AcquireNextImageInfoKHR build() {
-    return AcquireNextImageInfoKHR{native};
+  PipelineLayout build() const {
+    // clang-format off
+    const auto create_info = VkPipelineLayoutCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .setLayoutCount = 0,
+      .pSetLayouts = nullptr,
+      .pushConstantRangeCount = static_cast<uint32_t>(push_constant_ranges.size()),
+      .pPushConstantRanges = push_constant_ranges.data(),
+    };
+    // clang-format on
+
+    VkPipelineLayout pipeline_layout;
+    if (vkCreatePipelineLayout(device, &create_info, helper::allocation_callbacks(), &pipeline_layout) != VK_SUCCESS)
+      throw std::runtime_error{"Unable to create the pipeline layout"};
+
+    return PipelineLayout{pipeline_layout, &device};
   }
 
 private:
-  VkAcquireNextImageInfoKHR native;
+  Device& device;
+  std::vector<VkPushConstantRange> push_constant_ranges;
 };
 
-class CommandPool {
-  friend class CommandPoolBuilder;
+class Pipeline {
+  friend class GraphicsPipelineBuilder;
 
 public:
-  using NativeHandle = VkCommandPool;
+  using NativeHandle = VkPipeline;
 
-  CommandPool(std::nullptr_t) : handle{VK_NULL_HANDLE}, device{nullptr} {}
+  Pipeline(std::nullptr_t) noexcept : handle{VK_NULL_HANDLE}, device{nullptr} {}
 
-  CommandPool(const CommandPool&) = delete;
-  CommandPool& operator=(const CommandPool&) = delete;
+  Pipeline(const Pipeline&) = delete;
+  Pipeline& operator=(const Pipeline&) = delete;
 
-  CommandPool(CommandPool&& other) noexcept : handle{other.handle}, device{other.device} {
+  Pipeline(Pipeline&& other) noexcept : handle{other.handle}, device{other.device} {
     other.handle = VK_NULL_HANDLE;
     other.device = nullptr;
   }
 
-  CommandPool& operator=(CommandPool&& other) noexcept {
+  Pipeline& operator=(Pipeline&& other) noexcept {
     std::swap(handle, other.handle);
     std::swap(device, other.device);
     return *this;
   }
 
-  ~CommandPool() {
+  ~Pipeline() {
     if (handle == VK_NULL_HANDLE)
       return;
 
-    vkDestroyCommandPool(*device, handle, nullptr);
+    vkDestroyPipeline(*device, handle, helper::allocation_callbacks());
   }
 
   operator NativeHandle() const noexcept {
@@ -2051,51 +3169,266 @@ public:
   }
 
 private:
-  CommandPool(NativeHandle handle, Device* device) : handle{handle}, device{device} {}
+  Pipeline(NativeHandle handle, Device* device) noexcept : handle{handle}, device{device} {}
 
 private:
   NativeHandle handle = VK_NULL_HANDLE;
   Device* device = nullptr;
 };
 
-class CommandPoolBuilder {
+// Viewport and scissor are dynamic so the pipeline survives resizes. No depth test and no culling: 2D shapes are drawn
+// in submission order.
+class GraphicsPipelineBuilder {
 public:
-  explicit CommandPoolBuilder(Device& device) : device{device} {
+  GraphicsPipelineBuilder(Device& device, const PipelineLayout& layout, const RenderPass& render_pass) noexcept
+      : device{device}, layout{layout}, render_pass{render_pass} {}
+
+  // The entry point is not copied and must outlive build()
+  GraphicsPipelineBuilder& with_shader_stage(ShaderStageFlagBits stage, const ShaderModule& shader_module,
+                                             const char* entry_point = "main") {
+    shader_stages.push_back(VkPipelineShaderStageCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = {},
+        .stage = static_cast<VkShaderStageFlagBits>(stage),
+        .module = shader_module,
+        .pName = entry_point,
+        .pSpecializationInfo = nullptr,
+    });
+    return *this;
+  }
+
+  GraphicsPipelineBuilder& with_vertex_binding(std::size_t binding, std::size_t stride, VertexInputRate input_rate) {
+    vertex_bindings.push_back(VkVertexInputBindingDescription{
+        .binding = static_cast<uint32_t>(binding),
+        .stride = static_cast<uint32_t>(stride),
+        .inputRate = static_cast<VkVertexInputRate>(input_rate),
+    });
+    return *this;
+  }
+
+  GraphicsPipelineBuilder& with_vertex_attribute(std::size_t location, std::size_t binding, Format format,
+                                                 std::size_t offset) {
+    vertex_attributes.push_back(VkVertexInputAttributeDescription{
+        .location = static_cast<uint32_t>(location),
+        .binding = static_cast<uint32_t>(binding),
+        .format = static_cast<VkFormat>(format),
+        .offset = static_cast<uint32_t>(offset),
+    });
+    return *this;
+  }
+
+  GraphicsPipelineBuilder& with_topology(PrimitiveTopology primitive_topology) noexcept {
+    topology = primitive_topology;
+    return *this;
+  }
+
+  // Straight alpha blending over what is already in the attachment
+  GraphicsPipelineBuilder& with_alpha_blending(bool enable = true) noexcept {
+    alpha_blending = enable;
+    return *this;
+  }
+
+  Pipeline build() const {
     // clang-format off
-    command_pool_create_info = VkCommandPoolCreateInfo{
-      .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+    const auto vertex_input_state = VkPipelineVertexInputStateCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
       .pNext = nullptr,
-      .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-      .queueFamilyIndex = {},
+      .flags = {},
+      .vertexBindingDescriptionCount = static_cast<uint32_t>(vertex_bindings.size()),
+      .pVertexBindingDescriptions = vertex_bindings.data(),
+      .vertexAttributeDescriptionCount = static_cast<uint32_t>(vertex_attributes.size()),
+      .pVertexAttributeDescriptions = vertex_attributes.data(),
+    };
+
+    const auto input_assembly_state = VkPipelineInputAssemblyStateCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .topology = static_cast<VkPrimitiveTopology>(topology),
+      .primitiveRestartEnable = VK_FALSE,
+    };
+
+    const auto viewport_state = VkPipelineViewportStateCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .viewportCount = 1,
+      .pViewports = nullptr,
+      .scissorCount = 1,
+      .pScissors = nullptr,
+    };
+
+    const auto rasterization_state = VkPipelineRasterizationStateCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .depthClampEnable = VK_FALSE,
+      .rasterizerDiscardEnable = VK_FALSE,
+      .polygonMode = VK_POLYGON_MODE_FILL,
+      .cullMode = VK_CULL_MODE_NONE,
+      .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+      .depthBiasEnable = VK_FALSE,
+      .depthBiasConstantFactor = 0.0f,
+      .depthBiasClamp = 0.0f,
+      .depthBiasSlopeFactor = 0.0f,
+      .lineWidth = 1.0f,
+    };
+
+    const auto multisample_state = VkPipelineMultisampleStateCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+      .sampleShadingEnable = VK_FALSE,
+      .minSampleShading = 0.0f,
+      .pSampleMask = nullptr,
+      .alphaToCoverageEnable = VK_FALSE,
+      .alphaToOneEnable = VK_FALSE,
+    };
+
+    const auto color_blend_attachment = VkPipelineColorBlendAttachmentState{
+      .blendEnable = alpha_blending ? VK_TRUE : VK_FALSE,
+      .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+      .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+      .colorBlendOp = VK_BLEND_OP_ADD,
+      .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+      .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+      .alphaBlendOp = VK_BLEND_OP_ADD,
+      .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+                        VK_COLOR_COMPONENT_A_BIT,
+    };
+
+    const auto color_blend_state = VkPipelineColorBlendStateCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .logicOpEnable = VK_FALSE,
+      .logicOp = VK_LOGIC_OP_COPY,
+      .attachmentCount = 1,
+      .pAttachments = &color_blend_attachment,
+      .blendConstants = {0.0f, 0.0f, 0.0f, 0.0f},
+    };
+
+    const VkDynamicState dynamic_states[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    const auto dynamic_state = VkPipelineDynamicStateCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .dynamicStateCount = static_cast<uint32_t>(std::size(dynamic_states)),
+      .pDynamicStates = dynamic_states,
+    };
+
+    const auto create_info = VkGraphicsPipelineCreateInfo{
+      .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+      .pNext = nullptr,
+      .flags = {},
+      .stageCount = static_cast<uint32_t>(shader_stages.size()),
+      .pStages = shader_stages.data(),
+      .pVertexInputState = &vertex_input_state,
+      .pInputAssemblyState = &input_assembly_state,
+      .pTessellationState = nullptr,
+      .pViewportState = &viewport_state,
+      .pRasterizationState = &rasterization_state,
+      .pMultisampleState = &multisample_state,
+      .pDepthStencilState = nullptr,
+      .pColorBlendState = &color_blend_state,
+      .pDynamicState = &dynamic_state,
+      .layout = layout,
+      .renderPass = render_pass,
+      .subpass = 0,
+      .basePipelineHandle = VK_NULL_HANDLE,
+      .basePipelineIndex = -1,
     };
     // clang-format on
+
+    VkPipeline pipeline;
+    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &create_info, helper::allocation_callbacks(), &pipeline) !=
+        VK_SUCCESS)
+      throw std::runtime_error{"Unable to create the graphics pipeline"};
+
+    return Pipeline{pipeline, &device};
   }
 
-  CommandPoolBuilder& with_next(void* next) {
-    command_pool_create_info.pNext = next;
+private:
+  Device& device;
+  const PipelineLayout& layout;
+  const RenderPass& render_pass;
+  std::vector<VkPipelineShaderStageCreateInfo> shader_stages;
+  std::vector<VkVertexInputBindingDescription> vertex_bindings;
+  std::vector<VkVertexInputAttributeDescription> vertex_attributes;
+  PrimitiveTopology topology = PrimitiveTopology::triangle_list;
+  bool alpha_blending = false;
+};
+
+class CommandBufferInheritanceInfo {
+  friend class CommandBufferInheritanceInfoBuilder;
+
+public:
+  using NativeType = VkCommandBufferInheritanceInfo;
+
+  operator const NativeType&() const noexcept {
+    return native_type;
+  }
+
+  operator const NativeType*() const noexcept {
+    return &native_type;
+  }
+
+  [[nodiscard]] bool has_render_pass() const noexcept {
+    return native_type.renderPass != VK_NULL_HANDLE;
+  }
+
+private:
+  explicit CommandBufferInheritanceInfo(const VkCommandBufferInheritanceInfo& native) : native_type{native} {}
+
+private:
+  NativeType native_type;
+};
+
+class CommandBufferInheritanceInfoBuilder {
+public:
+  CommandBufferInheritanceInfoBuilder() noexcept {
+    native_type = VkCommandBufferInheritanceInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = nullptr,
+        .renderPass = VK_NULL_HANDLE,
+        .subpass = 0,
+        .framebuffer = VK_NULL_HANDLE,
+        .occlusionQueryEnable = VK_FALSE,
+        .queryFlags = 0,
+        .pipelineStatistics = 0,
+    };
+  }
+
+  CommandBufferInheritanceInfoBuilder& with_next(const void* next) noexcept {
+    native_type.pNext = next;
     return *this;
   }
 
-  CommandPoolBuilder& with_queue_family_index(std::size_t index) {
-    command_pool_create_info.queueFamilyIndex = static_cast<uint32_t>(index);
+  CommandBufferInheritanceInfoBuilder& with_render_pass(VkRenderPass render_pass, std::size_t subpass = 0) noexcept {
+    native_type.renderPass = render_pass;
+    native_type.subpass = static_cast<uint32_t>(subpass);
     return *this;
   }
 
-  CommandPoolBuilder& with_flags(CommandPoolCreateFlags required_flags) {
-    command_pool_create_info.flags = static_cast<VkCommandPoolCreateFlags>(required_flags);
+  CommandBufferInheritanceInfoBuilder& with_framebuffer(VkFramebuffer framebuffer) noexcept {
+    native_type.framebuffer = framebuffer;
     return *this;
   }
 
-  CommandPool build() const noexcept {
-    VkCommandPool command_pool;
-    vkCreateCommandPool(device, &command_pool_create_info, nullptr, &command_pool);
+  // Required when the primary command buffer has a pipeline statistics query active around the secondaries
+  CommandBufferInheritanceInfoBuilder& with_pipeline_statistics(QueryPipelineStatisticFlags statistics) noexcept {
+    native_type.pipelineStatistics = static_cast<VkQueryPipelineStatisticFlags>(statistics);
+    return *this;
+  }
 
-    return CommandPool{command_pool, &device};
+  CommandBufferInheritanceInfo build() const noexcept {
+    return CommandBufferInheritanceInfo{native_type};
   }
 
 private:
-  VkCommandPoolCreateInfo command_pool_create_info;
-  Device& device;
+  VkCommandBufferInheritanceInfo native_type;
 };
 
 class CommandBufferBeginInfo {
@@ -2142,6 +3475,12 @@ public:
     return *this;
   }
 
+  // Mandatory for secondary command buffers, the info must outlive the begin info
+  CommandBufferBeginInfoBuilder& with_inheritance_info(const CommandBufferInheritanceInfo& inheritance_info) noexcept {
+    native_type.pInheritanceInfo = inheritance_info;
+    return *this;
+  }
+
   CommandBufferBeginInfo build() const noexcept {
     return CommandBufferBeginInfo{native_type};
   }
@@ -2157,8 +3496,8 @@ public:
   using NativeHandle = VkCommandBuffer;
 
   void pipeline_barrier(PipelineStageFlags src_stage_mask, PipelineStageFlags dst_stage_mask, DependencyFlags dep_flags,
-                        const std::vector<MemoryBarrier>& memory_barriers,
-                        const std::vector<ImageMemoryBarrier>& image_memory_barriers) const noexcept {
+                        std::span<const MemoryBarrier> memory_barriers,
+                        std::span<const ImageMemoryBarrier> image_memory_barriers) const noexcept {
     vkCmdPipelineBarrier(handle, static_cast<VkPipelineStageFlags>(src_stage_mask),
                          static_cast<VkPipelineStageFlags>(dst_stage_mask), static_cast<VkDependencyFlags>(dep_flags),
                          static_cast<uint32_t>(memory_barriers.size()),
@@ -2168,7 +3507,7 @@ public:
   }
 
   void pipeline_barrier(PipelineStageFlags src_stage_mask, PipelineStageFlags dst_stage_mask, DependencyFlags dep_flags,
-                        const std::vector<ImageMemoryBarrier>& image_memory_barriers) const noexcept {
+                        std::span<const ImageMemoryBarrier> image_memory_barriers) const noexcept {
     vkCmdPipelineBarrier(handle, static_cast<VkPipelineStageFlags>(src_stage_mask),
                          static_cast<VkPipelineStageFlags>(dst_stage_mask), static_cast<VkDependencyFlags>(dep_flags),
                          0, nullptr, 0, nullptr, static_cast<uint32_t>(image_memory_barriers.size()),
@@ -2176,7 +3515,7 @@ public:
   }
 
   void pipeline_barrier(PipelineStageFlags src_stage_mask, PipelineStageFlags dst_stage_mask,
-                        const std::vector<ImageMemoryBarrier>& image_memory_barriers) const noexcept {
+                        std::span<const ImageMemoryBarrier> image_memory_barriers) const noexcept {
     vkCmdPipelineBarrier(handle, static_cast<VkPipelineStageFlags>(src_stage_mask),
                          static_cast<VkPipelineStageFlags>(dst_stage_mask), {}, {}, {}, {}, {},
                          static_cast<uint32_t>(image_memory_barriers.size()),
@@ -2191,6 +3530,103 @@ public:
                          std::bit_cast<const VkImageSubresourceRange*>(sub_ranges.data()));
   }
 
+  // Copies the first mip level of a color image into a tightly packed buffer
+  void copy_image_to_buffer(const Image& image, ImageLayout image_layout, const Buffer& buffer, int width,
+                            int height) const noexcept;
+
+  // Queries must be reset before they are written again, outside of a render pass
+  void reset_query_pool(const QueryPool& query_pool, std::size_t first, std::size_t count) const noexcept {
+    vkCmdResetQueryPool(handle, query_pool, static_cast<uint32_t>(first), static_cast<uint32_t>(count));
+  }
+
+  // Writes the GPU time once all the previous commands reached the given stage
+  void write_timestamp(PipelineStageFlagBits stage, const QueryPool& query_pool, std::size_t query) const noexcept {
+    vkCmdWriteTimestamp(handle, static_cast<VkPipelineStageFlagBits>(stage), query_pool, static_cast<uint32_t>(query));
+  }
+
+  void begin_query(const QueryPool& query_pool, std::size_t query) const noexcept {
+    vkCmdBeginQuery(handle, query_pool, static_cast<uint32_t>(query), 0);
+  }
+
+  void end_query(const QueryPool& query_pool, std::size_t query) const noexcept {
+    vkCmdEndQuery(handle, query_pool, static_cast<uint32_t>(query));
+  }
+
+  // The clear value is only used by attachments loaded with AttachmentLoadOp::clear
+  void begin_render_pass(const RenderPass& render_pass, const Framebuffer& framebuffer, int width, int height,
+                         const vis::vec4& clear_color, SubpassContents contents) const noexcept {
+    const auto clear_value = VkClearValue{
+        .color = VkClearColorValue{.float32 = {clear_color.r, clear_color.g, clear_color.b, clear_color.a}},
+    };
+
+    // clang-format off
+    const auto begin_info = VkRenderPassBeginInfo{
+      .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+      .pNext = nullptr,
+      .renderPass = render_pass,
+      .framebuffer = framebuffer,
+      .renderArea = VkRect2D{
+        .offset = VkOffset2D{0, 0},
+        .extent = VkExtent2D{static_cast<uint32_t>(width), static_cast<uint32_t>(height)},
+      },
+      .clearValueCount = 1,
+      .pClearValues = &clear_value,
+    };
+    // clang-format on
+
+    vkCmdBeginRenderPass(handle, &begin_info, static_cast<VkSubpassContents>(contents));
+  }
+
+  void end_render_pass() const noexcept {
+    vkCmdEndRenderPass(handle);
+  }
+
+  void bind_pipeline(const Pipeline& pipeline) const noexcept {
+    vkCmdBindPipeline(handle, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+  }
+
+  void bind_vertex_buffer(std::size_t binding, const Buffer& buffer, DeviceSize offset = 0) const noexcept;
+
+  template <typename T>
+  void push_constants(const PipelineLayout& layout, ShaderStageFlags stages, const T& value,
+                      std::size_t offset = 0) const noexcept {
+    static_assert(std::is_trivially_copyable_v<T>);
+    vkCmdPushConstants(handle, layout, static_cast<VkShaderStageFlags>(stages), static_cast<uint32_t>(offset),
+                       static_cast<uint32_t>(sizeof(T)), &value);
+  }
+
+  void set_viewport(int width, int height) const noexcept {
+    const auto viewport = VkViewport{
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = static_cast<float>(width),
+        .height = static_cast<float>(height),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    vkCmdSetViewport(handle, 0, 1, &viewport);
+  }
+
+  void set_scissor(int width, int height) const noexcept {
+    const auto scissor = VkRect2D{
+        .offset = VkOffset2D{0, 0},
+        .extent = VkExtent2D{static_cast<uint32_t>(width), static_cast<uint32_t>(height)},
+    };
+    vkCmdSetScissor(handle, 0, 1, &scissor);
+  }
+
+  void draw(std::size_t vertex_count, std::size_t instance_count = 1, std::size_t first_vertex = 0,
+            std::size_t first_instance = 0) const noexcept {
+    vkCmdDraw(handle, static_cast<uint32_t>(vertex_count), static_cast<uint32_t>(instance_count),
+              static_cast<uint32_t>(first_vertex), static_cast<uint32_t>(first_instance));
+  }
+
+  // Runs secondary command buffers from this primary one
+  void execute_commands(std::span<const CommandBuffer> secondaries) const noexcept {
+    vkCmdExecuteCommands(handle, static_cast<uint32_t>(secondaries.size()),
+                         reinterpret_cast<const NativeHandle*>(secondaries.data()));
+  }
+
   void start_recording(const CommandBufferBeginInfo& info) const noexcept {
     vkBeginCommandBuffer(handle, info);
   }
@@ -2252,6 +3688,10 @@ public:
     return CommandBuffer{command_buffers[index]};
   }
 
+  std::size_t size() const noexcept {
+    return command_buffers.size();
+  }
+
 private:
   CommandBuffers(Device* device, CommandPool* command_pool, std::vector<VkCommandBuffer>&& command_buffers)
       : device{device}, command_pool{command_pool}, command_buffers{std::move(command_buffers)} {}
@@ -2264,45 +3704,55 @@ private:
 
 class SubmitInfoBuilder {
 public:
-  SubmitInfoBuilder() {
-    native = VkSubmitInfo{};
-    native.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-  }
+  SubmitInfoBuilder() = default;
 
   SubmitInfoBuilder& with_next() noexcept {
-    native.pNext = nullptr;
+    submit_info.next = nullptr;
     return *this;
   }
 
   SubmitInfoBuilder& with_wait_semaphore(const Semaphore& semaphore) noexcept {
-    native.waitSemaphoreCount = 1;
-    native.pWaitSemaphores = reinterpret_cast<const Semaphore::NativeHandle*>(&semaphore);
+    return with_wait_semaphore(semaphore, PipelineStageFlagBits::all_commands_bit, 0);
+  }
+
+  // value is the timeline point to wait for, it is ignored for binary semaphores
+  SubmitInfoBuilder& with_wait_semaphore(const Semaphore& semaphore, PipelineStageFlags stage,
+                                         uint64_t value) noexcept {
+    submit_info.wait_semaphores.push_back(semaphore);
+    submit_info.wait_stages.push_back(static_cast<VkPipelineStageFlags>(stage));
+    submit_info.wait_values.push_back(value);
     return *this;
   }
 
-  SubmitInfoBuilder& with_dst_stage_mask(PipelineStageFlags& flags) noexcept {
-    native.pWaitDstStageMask = reinterpret_cast<PipelineStageFlags::MaskType*>(&flags);
+  // applies to the waits added so far
+  SubmitInfoBuilder& with_dst_stage_mask(PipelineStageFlags flags) noexcept {
+    std::ranges::fill(submit_info.wait_stages, static_cast<VkPipelineStageFlags>(flags));
     return *this;
   }
 
   SubmitInfoBuilder& with_command_buffer(const CommandBuffer& command_buffer) noexcept {
-    native.commandBufferCount = 1;
-    native.pCommandBuffers = reinterpret_cast<const CommandBuffer::NativeHandle*>(&command_buffer);
+    submit_info.command_buffers.push_back(command_buffer);
     return *this;
   }
 
   SubmitInfoBuilder& with_signal_semaphore(const Semaphore& semaphore) noexcept {
-    native.signalSemaphoreCount = 1;
-    native.pSignalSemaphores = reinterpret_cast<const Semaphore::NativeHandle*>(&semaphore);
+    return with_signal_semaphore(semaphore, 0);
+  }
+
+  // value is the timeline point to signal, it is ignored for binary semaphores
+  SubmitInfoBuilder& with_signal_semaphore(const Semaphore& semaphore, uint64_t value) noexcept {
+    submit_info.signal_semaphores.push_back(semaphore);
+    submit_info.signal_values.push_back(value);
     return *this;
   }
 
-  SubmitInfo build() noexcept {
-    return SubmitInfo(native);
+  SubmitInfo build() const {
+    SubmitInfo result{submit_info};
+    return result;
   }
 
 private:
-  VkSubmitInfo native;
+  SubmitInfo submit_info;
 };
 
 class PresentInfoBuilder {
@@ -2391,12 +3841,39 @@ public:
 
   explicit Buffer(std::nullptr_t) noexcept : handle{VK_NULL_HANDLE}, device{nullptr} {}
 
+  Buffer(const Buffer&) = delete;
+  Buffer& operator=(const Buffer&) = delete;
+
+  Buffer(Buffer&& other) noexcept : handle{other.handle}, device{other.device} {
+    other.handle = VK_NULL_HANDLE;
+    other.device = nullptr;
+  }
+
+  Buffer& operator=(Buffer&& other) noexcept {
+    std::swap(handle, other.handle);
+    std::swap(device, other.device);
+    return *this;
+  }
+
   ~Buffer() noexcept {
-    vkDestroyBuffer(*device, handle, nullptr);
+    if (handle == VK_NULL_HANDLE)
+      return;
+
+    vkDestroyBuffer(*device, handle, helper::allocation_callbacks());
   }
 
   operator NativeHandle() const noexcept { return handle; }
 
+  [[nodiscard]] VkMemoryRequirements get_memory_requirements() const noexcept {
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(*device, handle, &requirements);
+    return requirements;
+  }
+
+  void bind_memory(const DeviceMemory& memory, DeviceSize offset = 0) const noexcept {
+    vkBindBufferMemory(*device, handle, memory, offset);
+  }
+
 private:
   Buffer(Device* device, NativeHandle handle) noexcept : handle{handle}, device{device} {}
 
@@ -2453,7 +3930,7 @@ class BufferBuilder {
 
   Buffer build() const noexcept {
     Buffer buffer{&device, VK_NULL_HANDLE};
-    vkCreateBuffer(device, &native_type, nullptr, &buffer.handle);
+    vkCreateBuffer(device, &native_type, helper::allocation_callbacks(), &buffer.handle);
     return buffer;
   }
 
@@ -2462,6 +3939,31 @@ private:
   Device& device;
 };
 
+void CommandBuffer::copy_image_to_buffer(const Image& image, ImageLayout image_layout, const Buffer& buffer,
+                                         int width, int height) const noexcept {
+  // clang-format off
+  const auto region = VkBufferImageCopy{
+    .bufferOffset = 0,
+    .bufferRowLength = 0,
+    .bufferImageHeight = 0,
+    .imageSubresource = VkImageSubresourceLayers{
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .mipLevel = 0,
+      .baseArrayLayer = 0,
+      .layerCount = 1,
+    },
+    .imageOffset = VkOffset3D{0, 0, 0},
+    .imageExtent = VkExtent3D{static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1},
+  };
+  // clang-format on
+
+  vkCmdCopyImageToBuffer(handle, image, static_cast<VkImageLayout>(image_layout), buffer, 1, &region);
+}
+
+void CommandBuffer::bind_vertex_buffer(std::size_t binding, const Buffer& buffer, DeviceSize offset) const noexcept {
+  const VkBuffer native_buffer = buffer;
+  vkCmdBindVertexBuffers(handle, static_cast<uint32_t>(binding), 1, &native_buffer, &offset);
+}
 
 
 } // namespace vkh
\ No newline at end of file
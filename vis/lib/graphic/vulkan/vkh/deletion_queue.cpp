@@ -0,0 +1,60 @@
+export module vis.graphic.vulkan.vkh:deletion_queue;
+
+import std;
+
+export namespace vkh {
+
+// Keeps retired objects (old swapchains, render targets...) alive until the GPU finished the last frame that could
+// still use them, so nothing has to wait for the device to go idle. Frames are the values of a monotonically
+// increasing counter such as the renderer frame timeline.
+class DeletionQueue {
+public:
+  DeletionQueue() noexcept = default;
+
+  DeletionQueue(const DeletionQueue&) = delete;
+  DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+  DeletionQueue(DeletionQueue&&) noexcept = default;
+  DeletionQueue& operator=(DeletionQueue&&) noexcept = default;
+
+  template <typename T> void push(std::uint64_t last_used_frame, T&& resource) {
+    entries.push_back(Entry{
+        .last_used_frame = last_used_frame,
+        .resource = std::make_unique<Holder<std::remove_cvref_t<T>>>(std::forward<T>(resource)),
+    });
+  }
+
+  // Destroys every resource whose last frame is not newer than completed_frame
+  void collect(std::uint64_t completed_frame) noexcept {
+    while (not entries.empty() and entries.front().last_used_frame <= completed_frame)
+      entries.pop_front();
+  }
+
+  void clear() noexcept {
+    entries.clear();
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept {
+    return entries.size();
+  }
+
+private:
+  struct Resource {
+    virtual ~Resource() = default;
+  };
+
+  template <typename T> struct Holder final : Resource {
+    explicit Holder(T&& resource) : resource{std::move(resource)} {}
+    T resource;
+  };
+
+  struct Entry {
+    std::uint64_t last_used_frame = 0;
+    std::unique_ptr<Resource> resource;
+  };
+
+  // frames are pushed in increasing order, so the oldest entries are always at the front
+  std::deque<Entry> entries;
+};
+
+} // namespace vkh
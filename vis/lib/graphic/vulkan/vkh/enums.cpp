@@ -829,4 +829,140 @@ enum class SharingMode {
   concurrent = VK_SHARING_MODE_CONCURRENT,
 };
 
+enum class MemoryPropertyFlagBits : VkMemoryPropertyFlags {
+  device_local_bit = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+  host_visible_bit = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+  host_coherent_bit = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+  host_cached_bit = VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+  lazily_allocated_bit = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT,
+  protected_bit = VK_MEMORY_PROPERTY_PROTECTED_BIT,
+};
+
+template <> struct FlagTraits<MemoryPropertyFlagBits> {
+  static constexpr bool is_bitmask = true;
+};
+
+using MemoryPropertyFlags = Flags<MemoryPropertyFlagBits>;
+
+MemoryPropertyFlags operator|(MemoryPropertyFlagBits lhs, MemoryPropertyFlagBits rhs) {
+  return MemoryPropertyFlags{std::to_underlying(lhs) | std::to_underlying(rhs)};
+}
+
+enum class ImageTiling {
+  optimal = VK_IMAGE_TILING_OPTIMAL,
+  linear = VK_IMAGE_TILING_LINEAR,
+};
+
+enum class PresentResult {
+  success = VK_SUCCESS,
+  suboptimal = VK_SUBOPTIMAL_KHR,
+  out_of_date = VK_ERROR_OUT_OF_DATE_KHR,
+  surface_lost = VK_ERROR_SURFACE_LOST_KHR,
+  device_lost = VK_ERROR_DEVICE_LOST,
+};
+
+enum class SemaphoreType {
+  binary = VK_SEMAPHORE_TYPE_BINARY,
+  timeline = VK_SEMAPHORE_TYPE_TIMELINE,
+};
+
+enum class QueryType {
+  occlusion = VK_QUERY_TYPE_OCCLUSION,
+  pipeline_statistics = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+  timestamp = VK_QUERY_TYPE_TIMESTAMP,
+};
+
+enum class QueryPipelineStatisticFlagBits : VkQueryPipelineStatisticFlags {
+  input_assembly_vertices_bit = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT,
+  input_assembly_primitives_bit = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT,
+  vertex_shader_invocations_bit = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT,
+  geometry_shader_invocations_bit = VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_INVOCATIONS_BIT,
+  geometry_shader_primitives_bit = VK_QUERY_PIPELINE_STATISTIC_GEOMETRY_SHADER_PRIMITIVES_BIT,
+  clipping_invocations_bit = VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT,
+  clipping_primitives_bit = VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT,
+  fragment_shader_invocations_bit = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT,
+  tessellation_control_shader_patches_bit = VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT,
+  tessellation_evaluation_shader_invocations_bit =
+      VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT,
+  compute_shader_invocations_bit = VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT,
+};
+
+template <> struct FlagTraits<QueryPipelineStatisticFlagBits> {
+  static constexpr bool is_bitmask = true;
+};
+
+using QueryPipelineStatisticFlags = Flags<QueryPipelineStatisticFlagBits>;
+
+QueryPipelineStatisticFlags operator|(QueryPipelineStatisticFlagBits lhs, QueryPipelineStatisticFlagBits rhs) {
+  return QueryPipelineStatisticFlags{std::to_underlying(lhs) | std::to_underlying(rhs)};
+}
+
+enum class QueryResultFlagBits : VkQueryResultFlags {
+  result_64_bit = VK_QUERY_RESULT_64_BIT,
+  wait_bit = VK_QUERY_RESULT_WAIT_BIT,
+  with_availability_bit = VK_QUERY_RESULT_WITH_AVAILABILITY_BIT,
+  partial_bit = VK_QUERY_RESULT_PARTIAL_BIT,
+};
+
+template <> struct FlagTraits<QueryResultFlagBits> {
+  static constexpr bool is_bitmask = true;
+};
+
+using QueryResultFlags = Flags<QueryResultFlagBits>;
+
+QueryResultFlags operator|(QueryResultFlagBits lhs, QueryResultFlagBits rhs) {
+  return QueryResultFlags{std::to_underlying(lhs) | std::to_underlying(rhs)};
+}
+
+enum class AttachmentLoadOp {
+  load = VK_ATTACHMENT_LOAD_OP_LOAD,
+  clear = VK_ATTACHMENT_LOAD_OP_CLEAR,
+  dont_care = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+};
+
+enum class AttachmentStoreOp {
+  store = VK_ATTACHMENT_STORE_OP_STORE,
+  dont_care = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+};
+
+enum class SubpassContents {
+  inline_commands = VK_SUBPASS_CONTENTS_INLINE,
+  secondary_command_buffers = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS,
+};
+
+enum class ShaderStageFlagBits : VkShaderStageFlags {
+  vertex_bit = VK_SHADER_STAGE_VERTEX_BIT,
+  tessellation_control_bit = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
+  tessellation_evaluation_bit = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+  geometry_bit = VK_SHADER_STAGE_GEOMETRY_BIT,
+  fragment_bit = VK_SHADER_STAGE_FRAGMENT_BIT,
+  compute_bit = VK_SHADER_STAGE_COMPUTE_BIT,
+  all_graphics = VK_SHADER_STAGE_ALL_GRAPHICS,
+  all = VK_SHADER_STAGE_ALL,
+};
+
+template <> struct FlagTraits<ShaderStageFlagBits> {
+  static constexpr bool is_bitmask = true;
+};
+
+using ShaderStageFlags = Flags<ShaderStageFlagBits>;
+
+ShaderStageFlags operator|(ShaderStageFlagBits lhs, ShaderStageFlagBits rhs) {
+  return ShaderStageFlags{std::to_underlying(lhs) | std::to_underlying(rhs)};
+}
+
+enum class VertexInputRate {
+  vertex = VK_VERTEX_INPUT_RATE_VERTEX,
+  instance = VK_VERTEX_INPUT_RATE_INSTANCE,
+};
+
+enum class PrimitiveTopology {
+  point_list = VK_PRIMITIVE_TOPOLOGY_POINT_LIST,
+  line_list = VK_PRIMITIVE_TOPOLOGY_LINE_LIST,
+  line_strip = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP,
+  triangle_list = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+  triangle_strip = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+  triangle_fan = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN,
+};
+
 } // namespace vkh
\ No newline at end of file
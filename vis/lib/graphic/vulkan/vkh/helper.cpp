@@ -5,6 +5,7 @@ module;
 module vis.graphic.vulkan.vkh:helper;
 
 import std;
+import vis.memory;
 
 import :traits;
 import :concepts;
@@ -46,6 +47,54 @@ std::string vk_api_version_to_string(uint32_t version) noexcept {
                      api_version_variant(version));
 }
 
+#ifdef VIS_TRACK_ALLOCATIONS
+VKAPI_ATTR void* VKAPI_CALL tracked_allocation(void*, std::size_t size, std::size_t alignment,
+                                               VkSystemAllocationScope) {
+  return vis::memory::tracked_allocate(size, alignment, vis::memory::AllocationTag::vk);
+}
+
+VKAPI_ATTR void* VKAPI_CALL tracked_reallocation(void*, void* original, std::size_t size, std::size_t alignment,
+                                                 VkSystemAllocationScope scope) {
+  if (original == nullptr)
+    return tracked_allocation(nullptr, size, alignment, scope);
+
+  if (size == 0) {
+    vis::memory::tracked_free(original);
+    return nullptr;
+  }
+
+  // on failure the original allocation is left as it is
+  auto* reallocated = tracked_allocation(nullptr, size, alignment, scope);
+  if (reallocated != nullptr) {
+    std::memcpy(reallocated, original, std::min(size, vis::memory::tracked_size(original)));
+    vis::memory::tracked_free(original);
+  }
+  return reallocated;
+}
+
+VKAPI_ATTR void VKAPI_CALL tracked_free(void*, void* memory) {
+  vis::memory::tracked_free(memory);
+}
+#endif
+
+// Host memory of the driver, counted for the vk tag when tracking allocations, or nullptr to let the driver allocate.
+// An object has to be destroyed with the callbacks it was created with, so every create and destroy goes through it.
+const VkAllocationCallbacks* allocation_callbacks() noexcept {
+#ifdef VIS_TRACK_ALLOCATIONS
+  static constexpr VkAllocationCallbacks callbacks{
+      .pUserData = nullptr,
+      .pfnAllocation = tracked_allocation,
+      .pfnReallocation = tracked_reallocation,
+      .pfnFree = tracked_free,
+      .pfnInternalAllocation = nullptr,
+      .pfnInternalFree = nullptr,
+  };
+  return &callbacks;
+#else
+  return nullptr;
+#endif
+}
+
 } // namespace helper
 
 export namespace vkh {
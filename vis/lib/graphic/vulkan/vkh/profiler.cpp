@@ -0,0 +1,234 @@
+export module vis.graphic.vulkan.vkh:profiler;
+
+import std;
+
+import :enums;
+import :builders;
+
+export namespace vkh {
+
+struct GpuPassTiming {
+  std::string label;
+  std::uint64_t frame_number = 0;
+  std::chrono::duration<double, std::milli> gpu_time{};
+  // stay zero when the device cannot count pipeline statistics
+  std::uint64_t input_assembly_vertices = 0;
+  std::uint64_t vertex_shader_invocations = 0;
+  std::uint64_t clipping_primitives = 0;
+  std::uint64_t fragment_shader_invocations = 0;
+};
+
+// Times labelled passes with a timestamp query pool per frame in flight, plus a pipeline statistics pool when the
+// device supports them. A frame slot is read back when it is recorded again: the GPU is done with it by then, so the
+// results are a few frames old but reading them never waits.
+class GpuProfiler {
+  friend class GpuProfilerBuilder;
+
+public:
+  static constexpr std::size_t max_passes = 16;
+
+  GpuProfiler(std::nullptr_t) noexcept {}
+
+  GpuProfiler(const GpuProfiler&) = delete;
+  GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+  GpuProfiler(GpuProfiler&&) noexcept = default;
+  GpuProfiler& operator=(GpuProfiler&&) noexcept = default;
+
+  // False when the queue family cannot write timestamps, every call is a no-op then
+  [[nodiscard]] bool is_enabled() const noexcept {
+    return not frames.empty();
+  }
+
+  // What secondary command buffers recorded inside a pass have to inherit
+  [[nodiscard]] QueryPipelineStatisticFlags pipeline_statistics() const noexcept {
+    return statistics;
+  }
+
+  // Reads what the previous use of the frame slot measured and resets its queries, the slot must not be in flight.
+  // Returns true when latest() changed.
+  bool begin_frame(const CommandBuffer& command_buffer, std::size_t frame, std::uint64_t frame_number) {
+    if (not is_enabled())
+      return false;
+
+    current_frame = frame;
+    auto& queries = frames[frame];
+    const auto collected = collect(queries);
+
+    queries.labels.clear();
+    queries.frame_number = frame_number;
+    command_buffer.reset_query_pool(queries.timestamps, 0, queries.timestamps.size());
+    if (has_statistics())
+      command_buffer.reset_query_pool(queries.statistics, 0, queries.statistics.size());
+
+    return collected;
+  }
+
+  // Passes do not nest, one has to end before the next begins. Passes past max_passes are not measured.
+  void begin_pass(const CommandBuffer& command_buffer, std::string_view label) {
+    if (not is_enabled() or frames[current_frame].labels.size() >= max_passes) {
+      pass_open = false;
+      return;
+    }
+
+    auto& queries = frames[current_frame];
+    const auto pass = queries.labels.size();
+    queries.labels.emplace_back(label);
+    command_buffer.write_timestamp(PipelineStageFlagBits::top_of_pipe_bit, queries.timestamps, pass * 2);
+    if (has_statistics())
+      command_buffer.begin_query(queries.statistics, pass);
+    pass_open = true;
+  }
+
+  void end_pass(const CommandBuffer& command_buffer) noexcept {
+    if (not std::exchange(pass_open, false))
+      return;
+
+    const auto& queries = frames[current_frame];
+    const auto pass = queries.labels.size() - 1;
+    if (has_statistics())
+      command_buffer.end_query(queries.statistics, pass);
+    command_buffer.write_timestamp(PipelineStageFlagBits::bottomo_of_pipe_bit, queries.timestamps, pass * 2 + 1);
+  }
+
+  // Passes of the most recent frame read back, in recording order
+  [[nodiscard]] std::span<const GpuPassTiming> latest() const noexcept {
+    return results;
+  }
+
+private:
+  struct FrameQueries {
+    QueryPool timestamps{nullptr};
+    QueryPool statistics{nullptr};
+    std::vector<std::string> labels;
+    std::uint64_t frame_number = 0;
+  };
+
+  GpuProfiler(std::vector<FrameQueries>&& frames, double timestamp_period, std::uint64_t timestamp_mask,
+              QueryPipelineStatisticFlags statistics) noexcept
+      : frames{std::move(frames)}, timestamp_period{timestamp_period}, timestamp_mask{timestamp_mask},
+        statistics{statistics} {}
+
+  bool has_statistics() const noexcept {
+    return static_cast<QueryPipelineStatisticFlags::MaskType>(statistics) != 0;
+  }
+
+  // a slot whose results are not there yet is dropped instead of waited for
+  bool collect(const FrameQueries& queries) {
+    const auto pass_count = queries.labels.size();
+    if (pass_count == 0)
+      return false;
+
+    // every value is followed by its availability
+    timestamp_values.resize(pass_count * 2 * 2);
+    if (not queries.timestamps.get_results(0, pass_count * 2, timestamp_values))
+      return false;
+
+    const auto statistics_stride = queries.statistics.values_per_query() + 1;
+    auto has_statistic_values = false;
+    if (has_statistics()) {
+      statistic_values.resize(pass_count * statistics_stride);
+      has_statistic_values = queries.statistics.get_results(0, pass_count, statistic_values);
+    }
+
+    results.resize(pass_count);
+    for (auto pass = 0uz; pass < pass_count; ++pass) {
+      const auto begin = timestamp_values[pass * 4];
+      const auto end = timestamp_values[pass * 4 + 2];
+      const auto ticks = (end - begin) & timestamp_mask;
+
+      auto& result = results[pass];
+      result.label = queries.labels[pass];
+      result.frame_number = queries.frame_number;
+      result.gpu_time = std::chrono::duration<double, std::nano>{static_cast<double>(ticks) * timestamp_period};
+
+      // the builder asks for the four counters below, they come back in bit order
+      const auto* values = has_statistic_values ? &statistic_values[pass * statistics_stride] : nullptr;
+      result.input_assembly_vertices = values ? values[0] : 0;
+      result.vertex_shader_invocations = values ? values[1] : 0;
+      result.clipping_primitives = values ? values[2] : 0;
+      result.fragment_shader_invocations = values ? values[3] : 0;
+    }
+
+    return true;
+  }
+
+private:
+  std::vector<FrameQueries> frames;
+  std::size_t current_frame = 0;
+  bool pass_open = false;
+  double timestamp_period = 1.0;
+  std::uint64_t timestamp_mask = 0;
+  QueryPipelineStatisticFlags statistics{};
+
+  std::vector<std::uint64_t> timestamp_values;
+  std::vector<std::uint64_t> statistic_values;
+  std::vector<GpuPassTiming> results;
+};
+
+class GpuProfilerBuilder {
+public:
+  GpuProfilerBuilder(const PhysicalDevice& physical_device, Device& device) noexcept
+      : physical_device{physical_device}, device{device} {}
+
+  GpuProfilerBuilder& with_queue_family_index(std::size_t index) noexcept {
+    queue_family_index = index;
+    return *this;
+  }
+
+  GpuProfilerBuilder& with_frame_count(std::size_t count) noexcept {
+    frame_count = count;
+    return *this;
+  }
+
+  // Only honoured when the device was created through PhysicalDeviceSelector::set_enable_pipeline_statistics and
+  // supports them
+  GpuProfilerBuilder& with_pipeline_statistics(bool enable = true) noexcept {
+    enable_statistics = enable;
+    return *this;
+  }
+
+  GpuProfiler build() const {
+    const auto valid_bits = physical_device.timestamp_valid_bits(queue_family_index);
+    if (valid_bits == 0)
+      return GpuProfiler{nullptr};
+
+    const auto statistics = enable_statistics and physical_device.has_pipeline_statistics_query()
+                                ? QueryPipelineStatisticFlagBits::input_assembly_vertices_bit |
+                                      QueryPipelineStatisticFlagBits::vertex_shader_invocations_bit |
+                                      QueryPipelineStatisticFlagBits::clipping_primitives_bit |
+                                      QueryPipelineStatisticFlagBits::fragment_shader_invocations_bit
+                                : QueryPipelineStatisticFlags{};
+
+    std::vector<GpuProfiler::FrameQueries> frames(frame_count);
+    for (auto& queries : frames) {
+      // clang-format off
+      queries.timestamps = QueryPoolBuilder{device}
+        .with_type(QueryType::timestamp)
+        .with_query_count(GpuProfiler::max_passes * 2)
+        .build();
+
+      if (static_cast<QueryPipelineStatisticFlags::MaskType>(statistics) != 0)
+        queries.statistics = QueryPoolBuilder{device}
+          .with_type(QueryType::pipeline_statistics)
+          .with_query_count(GpuProfiler::max_passes)
+          .with_pipeline_statistics(statistics)
+          .build();
+      // clang-format on
+
+      queries.labels.reserve(GpuProfiler::max_passes);
+    }
+
+    const auto timestamp_mask = valid_bits >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << valid_bits) - 1;
+    return GpuProfiler{std::move(frames), physical_device.timestamp_period(), timestamp_mask, statistics};
+  }
+
+private:
+  const PhysicalDevice& physical_device;
+  Device& device;
+  std::size_t queue_family_index = 0;
+  std::size_t frame_count = 1;
+  bool enable_statistics = false;
+};
+
+} // namespace vkh
@@ -0,0 +1,175 @@
+export module vis.graphic.vulkan.vkh:recording;
+
+import std;
+import vis.jobs;
+
+import :enums;
+import :builders;
+
+export namespace vkh {
+
+// Owns one command pool and one secondary command buffer per worker slot and per frame in flight. A slot is recorded
+// by exactly one thread at a time, so the pools are never shared between threads and need no locking.
+class ParallelRecorder {
+  friend class ParallelRecorderBuilder;
+
+public:
+  using RecordFunction = std::function<void(const CommandBuffer& command_buffer, std::size_t first, std::size_t last)>;
+
+  ParallelRecorder(std::nullptr_t) noexcept {}
+
+  ParallelRecorder(const ParallelRecorder&) = delete;
+  ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+  ParallelRecorder(ParallelRecorder&& other) noexcept
+      : thread_pool{other.thread_pool}, min_draws_per_slot{other.min_draws_per_slot},
+        frames{std::move(other.frames)} {
+    other.thread_pool = nullptr;
+  }
+
+  ParallelRecorder& operator=(ParallelRecorder&& other) noexcept {
+    std::swap(thread_pool, other.thread_pool);
+    std::swap(min_draws_per_slot, other.min_draws_per_slot);
+    std::swap(frames, other.frames);
+    return *this;
+  }
+
+  // Splits [0, draw_count) in contiguous ranges, records every range into its own secondary command buffer and
+  // returns them in draw order, ready for CommandBuffer::execute_commands. The buffers of the previous use of the same
+  // frame are recycled, so the frame must not be in flight anymore.
+  std::span<const CommandBuffer> record(std::size_t frame, std::size_t draw_count,
+                                        const CommandBufferInheritanceInfo& inheritance_info,
+                                        const RecordFunction& record_range) {
+    auto& slots = frames[frame];
+    slots.recorded.clear();
+
+    if (draw_count == 0)
+      return {};
+
+    const auto max_slot_count = std::min(slots.pools.size(), std::max(draw_count / min_draws_per_slot, 1uz));
+    const auto draws_per_slot = (draw_count + max_slot_count - 1) / max_slot_count;
+    const auto slot_count = (draw_count + draws_per_slot - 1) / draws_per_slot;
+
+    // secondaries executed inside a render pass must say so, otherwise the inherited render pass is ignored and their
+    // draws are outside of any render pass
+    auto usage = CommandBufferUsageFlags{CommandBufferUsageFlagBits::one_time_submit_bit};
+    if (inheritance_info.has_render_pass())
+      usage |= CommandBufferUsageFlagBits::render_pass_continue_bit;
+
+    // clang-format off
+    const auto begin_info = CommandBufferBeginInfoBuilder{}
+      .with_flags(usage)
+      .with_inheritance_info(inheritance_info)
+      .build();
+    // clang-format on
+
+    auto record_slot = [&](std::size_t slot) {
+      const auto first = slot * draws_per_slot;
+      const auto last = std::min(first + draws_per_slot, draw_count);
+
+      slots.pools[slot].reset();
+      const auto command_buffer = slots.command_buffers[slot][0];
+      command_buffer.start_recording(begin_info);
+      record_range(command_buffer, first, last);
+      command_buffer.end_recording();
+    };
+
+    if (slot_count == 1 or thread_pool == nullptr) {
+      for (auto slot = 0uz; slot < slot_count; ++slot)
+        record_slot(slot);
+    } else {
+      thread_pool->parallel_for(slot_count, record_slot);
+    }
+
+    for (auto slot = 0uz; slot < slot_count; ++slot)
+      slots.recorded.push_back(slots.command_buffers[slot][0]);
+
+    return slots.recorded;
+  }
+
+  std::size_t slot_count() const noexcept {
+    return frames.empty() ? 0 : frames.front().pools.size();
+  }
+
+private:
+  struct FrameSlots {
+    // declared before the buffers so the buffers are freed before their pools are destroyed
+    std::vector<CommandPool> pools;
+    std::vector<CommandBuffers> command_buffers;
+    std::vector<CommandBuffer> recorded;
+  };
+
+  ParallelRecorder(vis::jobs::ThreadPool* thread_pool, std::size_t min_draws_per_slot,
+                   std::vector<FrameSlots>&& frames) noexcept
+      : thread_pool{thread_pool}, min_draws_per_slot{min_draws_per_slot}, frames{std::move(frames)} {}
+
+private:
+  vis::jobs::ThreadPool* thread_pool = nullptr;
+  std::size_t min_draws_per_slot = 1;
+  std::vector<FrameSlots> frames;
+};
+
+class ParallelRecorderBuilder {
+public:
+  explicit ParallelRecorderBuilder(Device& device) noexcept : device{device} {}
+
+  ParallelRecorderBuilder& with_queue_family_index(std::size_t index) noexcept {
+    queue_family_index = index;
+    return *this;
+  }
+
+  ParallelRecorderBuilder& with_frame_count(std::size_t count) noexcept {
+    frame_count = count;
+    return *this;
+  }
+
+  // Opt-in: without a thread pool there is a single slot per frame and every range is recorded on the calling thread.
+  // Each worker adds a command pool and a secondary per frame, so only pass a pool when the draw lists are long enough
+  // to reach the minimum draws per thread.
+  ParallelRecorderBuilder& with_thread_pool(vis::jobs::ThreadPool& pool) noexcept {
+    thread_pool = &pool;
+    return *this;
+  }
+
+  // Small draw lists are not worth waking up workers for
+  ParallelRecorderBuilder& with_min_draws_per_thread(std::size_t count) noexcept {
+    min_draws_per_slot = std::max(count, 1uz);
+    return *this;
+  }
+
+  ParallelRecorder build() const {
+    const auto slot_count = thread_pool ? thread_pool->worker_count() + 1 : 1uz;
+
+    std::vector<ParallelRecorder::FrameSlots> frames(frame_count);
+    for (auto& slots : frames) {
+      slots.pools.reserve(slot_count);
+      slots.command_buffers.reserve(slot_count);
+      slots.recorded.reserve(slot_count);
+
+      // clang-format off
+      for (auto i = 0uz; i < slot_count; ++i)
+        slots.pools.emplace_back(CommandPoolBuilder{device}
+          .with_queue_family_index(queue_family_index)
+          .with_flags(CommandPoolCreateFlagBits::transfer)
+          .build());
+
+      for (auto& pool : slots.pools)
+        slots.command_buffers.emplace_back(CommandBuffersBuilder{device, pool}
+          .with_level(CommandBufferLevel::secondary)
+          .with_buffer_count(1)
+          .build());
+      // clang-format on
+    }
+
+    return ParallelRecorder{thread_pool, min_draws_per_slot, std::move(frames)};
+  }
+
+private:
+  Device& device;
+  vis::jobs::ThreadPool* thread_pool = nullptr;
+  std::size_t queue_family_index = 0;
+  std::size_t frame_count = 1;
+  std::size_t min_draws_per_slot = 64;
+};
+
+} // namespace vkh
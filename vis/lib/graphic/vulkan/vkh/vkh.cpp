@@ -6,4 +6,7 @@ export import :constants;
 export import :traits;
 export import :enums;
 export import :structures;
+export import :recording;
+export import :deletion_queue;
+export import :profiler;
 import :helper;
\ No newline at end of file
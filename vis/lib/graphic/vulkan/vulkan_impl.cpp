@@ -1,11 +1,19 @@
 module;
 
+// set by the build next to the compiled shaders, the fallback works when running from the build directory
+#ifndef VIS_SHADER_DIR
+#define VIS_SHADER_DIR "resources/shader"
+#endif
+
 module vis.graphic.vulkan;
 
 import std;
 import vis.graphic.vulkan.vkh;
 import vis.math;
 import vis.window;
+import vis.chrono;
+import vis.jobs;
+import vis.memory;
 
 namespace helper {
 constexpr vkh::InstanceCreateFlags get_required_instance_flags() noexcept {
@@ -18,14 +26,17 @@ constexpr vkh::InstanceCreateFlags get_required_instance_flags() noexcept {
   return flags;
 }
 
-std::vector<const char*> get_required_extensions() noexcept {
-  std::vector<const char*> required_extensions{
-      vkh::KHRGetPhysicalDeviceProperties2ExtensionName,
-      vkh::KHRGetSurfaceCapabilities2ExtensionName,
-  };
+std::vector<const char*> get_required_extensions(bool presentation) noexcept {
+  std::vector<const char*> required_extensions{vkh::KHRGetPhysicalDeviceProperties2ExtensionName};
+
+  if (presentation) {
+    required_extensions.push_back(vkh::KHRGetSurfaceCapabilities2ExtensionName);
+#if defined(__APPLE__)
+    required_extensions.push_back(vkh::EXTMetalSurfaceExtensionName);
+#endif
+  }
 
 #if defined(__APPLE__)
-  required_extensions.push_back(vkh::EXTMetalSurfaceExtensionName);
   required_extensions.push_back(vkh::KHRPortabilityEnumerationExtensionName);
 #endif
 
@@ -47,8 +58,10 @@ std::vector<const char*> get_required_layers() noexcept {
   return required_layers;
 }
 
-constexpr std::vector<const char*> get_physical_device_extensions() noexcept {
-  std::vector<const char*> required_extensions = {vkh::KHRSwapchainExtensionName};
+constexpr std::vector<const char*> get_physical_device_extensions(bool presentation) noexcept {
+  std::vector<const char*> required_extensions;
+  if (presentation)
+    required_extensions.push_back(vkh::KHRSwapchainExtensionName);
 
 #if defined(__APPLE__)
   required_extensions.push_back(vkh::KHRPortabilitySubsetExtensionName);
@@ -56,22 +69,71 @@ constexpr std::vector<const char*> get_physical_device_extensions() noexcept {
   return required_extensions;
 }
 
+std::vector<uint32_t> read_spirv(std::string_view file_name) {
+  const auto path = std::filesystem::path{VIS_SHADER_DIR} / file_name;
+  std::ifstream file{path, std::ios::binary | std::ios::ate};
+  if (not file)
+    throw std::runtime_error{std::format("Unable to open the shader {}", path.string())};
+
+  const auto size = static_cast<std::size_t>(file.tellg());
+  std::vector<uint32_t> words(size / sizeof(uint32_t));
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(words.data()), static_cast<std::streamsize>(words.size() * sizeof(uint32_t)));
+  return words;
+}
+
 } // namespace helper
 
 namespace vis::vulkan {
 
 class Renderer::Impl {
 public:
-  Impl([[maybe_unused]] Window* window) : window{window} {
-    init_instance();
-    init_surface();
-    auto physical_device_selector = vkh::PhysicalDeviceSelector{vk_instance, &surface};
-    enumerate_physical_devices(physical_device_selector);
-    init_device(physical_device_selector);
-    init_swapchain();
-    init_command_pool();
-    init_semaphores();
-    record_command_buffer();
+  // The shaders are read and the instance is created on the workers while the calling thread creates the window
+  Impl(const std::function<Window*()>& create_window, const LatencyPolicy& policy)
+      : latency_policy{policy}, frames_in_flight{std::max(policy.frames_in_flight, 1uz)} {
+    Window::init_renderer_library();
+    auto shader_code = load_shader_code();
+    auto instance_ready = thread_pool.submit([this] {
+      const auto phase = trace.measure("vulkan instance");
+      init_instance();
+    });
+
+    try {
+      {
+        const auto phase = trace.measure("window");
+        window = create_window();
+      }
+      instance_ready.get();
+
+      {
+        const auto phase = trace.measure("surface");
+        init_surface();
+      }
+      auto physical_device_selector = vkh::PhysicalDeviceSelector{vk_instance, &surface};
+      init_device_objects(physical_device_selector, shader_code);
+    } catch (...) {
+      wait_for_startup_jobs(instance_ready, shader_code);
+      throw;
+    }
+  }
+
+  Impl(Window* window, const LatencyPolicy& policy) : Impl([window] { return window; }, policy) {}
+
+  // the offscreen ring takes the place of the swapchain images, everything else is shared with the windowed path
+  Impl(const HeadlessConfig& config)
+      : headless{true}, width{config.width}, height{config.height}, frames_in_flight{std::max(config.ring_size, 1uz)} {
+    auto shader_code = load_shader_code();
+    try {
+      {
+        const auto phase = trace.measure("vulkan instance");
+        init_instance();
+      }
+      auto physical_device_selector = vkh::PhysicalDeviceSelector{vk_instance};
+      init_device_objects(physical_device_selector, shader_code);
+    } catch (...) {
+      wait_for_startup_jobs(shader_code);
+      throw;
+    }
   }
 
   ~Impl() {
@@ -82,31 +144,152 @@ public:
     return {};
   }
 
+  bool is_headless() const noexcept {
+    return headless;
+  }
+
+  // Only records the requested extent, the targets are rebuilt by the next draw() and only if the extent changed
   void set_viewport([[maybe_unused]] int x, [[maybe_unused]] int y, int view_width, int view_height) noexcept {
     width = view_width;
     height = view_height;
-    init_swapchain();
-    init_semaphores();
-    record_command_buffer();
-    frame_index = 0;
   }
 
   void set_clear_color([[maybe_unused]] vec4 color) noexcept {
     clear_color = color;
   }
 
-  void clear() const noexcept {
-    const auto& swapchain_images = swapchain.get_images();
-    for (auto i = 0uz; i < swapchain_images.size(); ++i) {
-      const auto& image = swapchain_images[i];
-      auto command_buffer = command_buffers[i];
-      command_buffer.clear_color(clear_color, image, vkh::ImageLayout::transfer_dst_optimal, {});
-    }
+  // every frame starts with the render pass clearing its target, nothing to do here
+  void clear() const noexcept {}
+
+  ShapeBatch& shapes() noexcept {
+    return shape_batch;
+  }
+
+  void set_view_projection(const Affine2D& projection) noexcept {
+    view_projection = projection;
   }
 
   void draw() noexcept {
-    in_flight_fences[frame_index].wait();
-    in_flight_fences[frame_index].reset();
+    const auto cpu_start = std::chrono::steady_clock::now();
+    wait_for_frame(frame_timeline_values[frame_index]);
+    const auto wait_end = std::chrono::steady_clock::now();
+    frame_memory.next_frame();
+
+    deletion_queue.collect(completed_frame);
+
+    if (is_headless())
+      submit_offscreen();
+    else
+      present();
+
+    // shapes of a frame that could not be presented are dropped, the next frame queues its own
+    shape_batch.clear();
+
+    if (submitted_frame != 0 and not first_frame_reported) {
+      first_frame_reported = true;
+      const auto time_to_first_frame = trace.mark("first frame presented");
+      std::println("first frame presented {} after startup\n{}", time_to_first_frame, trace.report());
+    }
+
+    update_frame_stats(cpu_start, wait_end, std::chrono::steady_clock::now());
+  }
+
+  std::optional<ReadbackImage> read_back() noexcept {
+    if (not is_headless())
+      return std::nullopt;
+
+    // pick the newest slot the GPU already finished, a slot still in flight is skipped rather than waited
+    std::optional<std::size_t> newest_slot;
+    for (auto i = 0uz; i < offscreen_frames.size(); ++i) {
+      const auto frame_number = offscreen_frames[i].frame_number;
+      if (frame_number <= last_read_frame or not is_frame_complete(frame_number))
+        continue;
+
+      if (not newest_slot or frame_number > offscreen_frames[*newest_slot].frame_number)
+        newest_slot = i;
+    }
+
+    if (not newest_slot)
+      return std::nullopt;
+
+    auto& frame = offscreen_frames[*newest_slot];
+    last_read_frame = frame.frame_number;
+
+    auto pixels = frame.readback_memory.map();
+    frame.readback_memory.invalidate();
+
+    return ReadbackImage{
+        .frame_number = frame.frame_number,
+        .width = target_width,
+        .height = target_height,
+        .pixels = pixels.first(readback_size()),
+    };
+  }
+
+  FrameStats frame_stats() const noexcept {
+    return stats;
+  }
+
+  void set_latency_policy(const LatencyPolicy& policy) {
+    if (is_headless())
+      return;
+
+    latency_policy = policy;
+    swapchain_out_of_date = swapchain_out_of_date or choose_present_mode() != present_mode;
+
+    const auto requested_frames_in_flight = std::max(policy.frames_in_flight, 1uz);
+    if (requested_frames_in_flight == frames_in_flight)
+      return;
+
+    // the per-frame objects are rebuilt, so every frame handed out so far has to be done with them
+    wait_for_frame(submitted_frame);
+    frames_in_flight = requested_frames_in_flight;
+    frame_index = 0;
+    init_command_pool();
+    init_shape_buffers();
+    frame_timeline_values.assign(frames_in_flight, submitted_frame);
+    init_semaphores();
+  }
+
+  PresentMode get_present_mode() const noexcept {
+    return present_mode;
+  }
+
+  void wait_for_next_frame() noexcept {
+    const auto wait_start = std::chrono::steady_clock::now();
+    wait_for_frame(frame_timeline_values[frame_index]);
+    pending_wait_time += std::chrono::steady_clock::now() - wait_start;
+  }
+
+private:
+  void submit_offscreen() noexcept {
+    if (width != target_width or height != target_height) {
+      // frames already submitted may still render into the old ring
+      deletion_queue.push(submitted_frame, std::move(offscreen_frames));
+      init_offscreen_targets();
+    }
+
+    record_frame(frame_index, frame_index);
+    const auto frame_number = submitted_frame + 1;
+    auto submit_info = vkh::SubmitInfoBuilder{}
+                           .with_command_buffer(command_buffers[frame_index])
+                           .with_signal_semaphore(frame_timeline, frame_number)
+                           .build();
+
+    graphic_queue.submit(submit_info);
+    submitted_frame = frame_number;
+    frame_timeline_values[frame_index] = frame_number;
+    offscreen_frames[frame_index].frame_number = frame_number;
+    increment_frame_index();
+  }
+
+  void present() noexcept {
+    if (swapchain_out_of_date or width != target_width or height != target_height)
+      init_swapchain();
+
+    // a minimized window has nothing to present to
+    if (target_width == 0 or target_height == 0)
+      return;
 
     // clang-format off
     [[maybe_unused]] auto acquire_info = vkh::AcquireNextImageInfoKHRBuilder{swapchain}
@@ -116,48 +299,165 @@ public:
 
     swapchain.acquire_image(acquire_info)
         .transform([this](std::size_t swap_chain_image_index) {
-          vkh::PipelineStageFlags dst_stage_mask = vkh::PipelineStageFlagBits::transfer_bit;
-          const vkh::CommandBuffer& cmd_buffer = command_buffers[swap_chain_image_index];
+          record_frame(frame_index, swap_chain_image_index);
 
+          const auto frame_number = submitted_frame + 1;
           auto submit_info = vkh::SubmitInfoBuilder{}
                                  .with_wait_semaphore(image_availables_sems[frame_index])
-                                 .with_dst_stage_mask(dst_stage_mask)
-                                 .with_command_buffer(cmd_buffer)
-                                 .with_signal_semaphore(rendering_finished_sems[frame_index])
+                                 .with_dst_stage_mask(vkh::PipelineStageFlagBits::color_attachment_output_bit)
+                                 .with_command_buffer(command_buffers[frame_index])
+                                 .with_signal_semaphore(rendering_finished_sems[swap_chain_image_index])
+                                 .with_signal_semaphore(frame_timeline, frame_number)
                                  .build();
 
-          graphic_queue.submit(submit_info, in_flight_fences[frame_index]);
+          graphic_queue.submit(submit_info);
+          submitted_frame = frame_number;
+          frame_timeline_values[frame_index] = frame_number;
 
           uint32_t image_index = static_cast<uint32_t>(swap_chain_image_index);
           auto present_info = vkh::PresentInfoBuilder{}
-                                  .with_wait_semaphore(rendering_finished_sems[frame_index])
+                                  .with_wait_semaphore(rendering_finished_sems[swap_chain_image_index])
                                   .with_image_index(image_index)
                                   .with_swapchain(swapchain)
                                   .build();
 
-          present_queue.present(present_info);
+          // suboptimal is fine to keep presenting to, a real size change comes through set_viewport
+          if (present_queue.present(present_info) == vkh::PresentResult::out_of_date)
+            swapchain_out_of_date = true;
           increment_frame_index();
         })
         .transform_error([this](vkh::Swapchain::AcquireImageError error) {
-          if (error == vkh::Swapchain::AcquireImageError::suboptimal)
-            set_viewport(0, 0, width, height);
+          if (error == vkh::Swapchain::AcquireImageError::out_of_date)
+            swapchain_out_of_date = true;
           return error;
         });
   }
 
+  void update_frame_stats(std::chrono::steady_clock::time_point cpu_start,
+                          std::chrono::steady_clock::time_point wait_end,
+                          std::chrono::steady_clock::time_point cpu_end) noexcept {
+    // a wait already paid in wait_for_next_frame counts as wait time of this frame
+    const auto wait_time = wait_end - cpu_start + std::exchange(pending_wait_time, {});
+    const auto cpu_time = cpu_end - wait_end;
+
+    total_cpu_time += cpu_time;
+    stats.frame_count += 1;
+    stats.last_cpu_time = std::chrono::duration_cast<chrono::milliseconds>(cpu_time);
+    stats.last_wait_time = std::chrono::duration_cast<chrono::milliseconds>(wait_time);
+    stats.average_cpu_time =
+        std::chrono::duration_cast<chrono::milliseconds>(total_cpu_time) / static_cast<float>(stats.frame_count);
+  }
+
+  void wait_for_frame(std::uint64_t frame_number) noexcept {
+    if (is_frame_complete(frame_number))
+      return;
+
+    frame_timeline.wait(frame_number);
+    completed_frame = std::max(completed_frame, frame_number);
+  }
+
+  // only asks the driver when the cached counter is not far enough yet
+  bool is_frame_complete(std::uint64_t frame_number) noexcept {
+    if (frame_number <= completed_frame)
+      return true;
+
+    completed_frame = frame_timeline.get_value();
+    return frame_number <= completed_frame;
+  }
+
+  struct ShapeShaderCode {
+    std::vector<uint32_t> vertex;
+    std::vector<uint32_t> quad_fragment;
+    std::vector<uint32_t> circle_fragment;
+  };
+
+  // The futures of submitted tasks do not wait on destruction and the startup jobs write into this object, so a
+  // constructor that throws waits for the ones still running before its members are destroyed under them
+  template <typename... Futures> static void wait_for_startup_jobs(Futures&... futures) noexcept {
+    ((futures.valid() ? futures.wait() : void()), ...);
+  }
+
+  // reading the files does not need the device, it overlaps with the instance and device creation
+  std::future<ShapeShaderCode> load_shader_code() {
+    return thread_pool.submit([this] {
+      const auto phase = trace.measure("shader loading");
+      return ShapeShaderCode{
+          .vertex = helper::read_spirv("shape2d.vert.spv"),
+          .quad_fragment = helper::read_spirv("shape2d.frag.spv"),
+          .circle_fragment = helper::read_spirv("circle2d.frag.spv"),
+      };
+    });
+  }
+
+  // Everything from the device on. The pipelines compile on the workers while the calling thread builds the render
+  // targets and the per-frame objects.
+  void init_device_objects(vkh::PhysicalDeviceSelector& physical_device_selector,
+                           std::future<ShapeShaderCode>& shader_code) {
+    {
+      const auto phase = trace.measure("physical devices");
+      enumerate_physical_devices(physical_device_selector);
+    }
+    {
+      const auto phase = trace.measure("device");
+      init_device(physical_device_selector);
+      init_render_pass();
+    }
+
+    const auto code = shader_code.get();
+    const auto vertex_shader = vkh::ShaderModuleBuilder{device}.with_code(code.vertex).build();
+    const auto quad_shader = vkh::ShaderModuleBuilder{device}.with_code(code.quad_fragment).build();
+    const auto circle_shader = vkh::ShaderModuleBuilder{device}.with_code(code.circle_fragment).build();
+    init_shape_pipeline_layout();
+
+    std::array pipelines_ready = {
+        thread_pool.submit([&] {
+          const auto phase = trace.measure("quad pipeline");
+          quad_pipeline = build_shape_pipeline(vertex_shader, quad_shader);
+        }),
+        thread_pool.submit([&] {
+          const auto phase = trace.measure("circle pipeline");
+          circle_pipeline = build_shape_pipeline(vertex_shader, circle_shader);
+        }),
+    };
+
+    try {
+      const auto phase = trace.measure("render targets and frame resources");
+      if (is_headless())
+        init_offscreen_targets();
+      else
+        init_swapchain();
+      init_command_pool();
+      init_shape_buffers();
+      init_frame_timeline();
+      init_semaphores();
+    } catch (...) {
+      // the pipeline jobs use the shader modules of this scope
+      for (auto& ready : pipelines_ready)
+        ready.wait();
+      throw;
+    }
+
+    // both jobs finish before the first failure unwinds this scope
+    for (auto& ready : pipelines_ready)
+      ready.wait();
+    for (auto& ready : pipelines_ready)
+      ready.get();
+  }
+
   void increment_frame_index() {
-    frame_index = frame_index + 1 - (frame_index + 1 >= swapchain_image_count) * swapchain_image_count;
+    frame_index = frame_index + 1 - (frame_index + 1 >= frames_in_flight) * frames_in_flight;
   }
 
-private:
   void init_instance() noexcept {
     auto required_flags = helper::get_required_instance_flags();
     required_layers = helper::get_required_layers();
-    required_extensions = helper::get_required_extensions();
-    auto required_windows_extensions = window->get_required_renderer_extension();
+    required_extensions = helper::get_required_extensions(not is_headless());
 
-    required_extensions.insert(end(required_extensions), begin(required_windows_extensions),
-                               end(required_windows_extensions));
+    if (not is_headless()) {
+      auto required_windows_extensions = Window::get_required_renderer_extension();
+      required_extensions.insert(end(required_extensions), begin(required_windows_extensions),
+                                 end(required_windows_extensions));
+    }
 
     vk_instance = vkh::InstanceBuilder{vk_context}
                       .with_app_name("Pong")
@@ -176,15 +476,22 @@ private:
   }
 
   void enumerate_physical_devices(vkh::PhysicalDeviceSelector& physical_device_selector) noexcept {
-    auto required_gpu_extensions = helper::get_physical_device_extensions();
+    auto required_gpu_extensions = helper::get_physical_device_extensions(not is_headless());
 
     // clang-format off
-    physical_devices = physical_device_selector
-                           .add_required_extensions(required_gpu_extensions)
-                           .allow_gpu_type(vkh::PhysicalDeviceType::DiscreteGpu)
-                           .allow_gpu_type(vkh::PhysicalDeviceType::IntegratedGpu)
-                           .enumerate_all();
+    physical_device_selector
+      .add_required_extensions(required_gpu_extensions)
+      .allow_gpu_type(vkh::PhysicalDeviceType::DiscreteGpu)
+      .allow_gpu_type(vkh::PhysicalDeviceType::IntegratedGpu)
+      .set_require_timeline_semaphore()
+      .set_enable_pipeline_statistics();
     // clang-format on
+
+    // software rasterizers are fine when nothing is presented, CI machines usually have nothing else
+    if (is_headless())
+      physical_device_selector.allow_gpu_type(vkh::PhysicalDeviceType::Cpu).set_require_preset();
+
+    physical_devices = physical_device_selector.enumerate_all();
   }
 
   void init_device(vkh::PhysicalDeviceSelector& physical_device_selector) {
@@ -192,7 +499,9 @@ private:
     if (selected_physical_device_it == end(physical_devices))
       throw std::runtime_error{"No suitable physical device found"};
 
-    present_queue_family_index = *selected_physical_device_it->get_first_graphic_and_present_queue_family_index();
+    present_queue_family_index =
+        is_headless() ? *selected_physical_device_it->get_first_graphic_queue_family_index()
+                      : *selected_physical_device_it->get_first_graphic_and_present_queue_family_index();
 
     std::println("selected device: {}", selected_physical_device_it->device_name());
 
@@ -211,112 +520,417 @@ private:
     graphic_queue = device.get_queue(present_queue_family_index);
     present_queue = device.get_queue(present_queue_family_index);
 
+    if (is_headless())
+      return;
+
     auto surface_caps = selected_physical_device_it->get_surface_capabilities();
     width = static_cast<int>(surface_caps.surfaceCapabilities.currentExtent.width);
     height = static_cast<int>(surface_caps.surfaceCapabilities.currentExtent.height);
-    swapchain_image_count = 3;
+  }
+
+  PresentMode choose_present_mode() const noexcept {
+    const auto& supported_modes = selected_physical_device_it->get_present_modes();
+    for (auto mode : latency_policy.present_modes) {
+      if (std::ranges::contains(supported_modes, static_cast<VkPresentModeKHR>(to_vkh(mode))))
+        return mode;
+    }
+    return PresentMode::fifo;
+  }
+
+  static vkh::PresentMode to_vkh(PresentMode mode) noexcept {
+    switch (mode) {
+    case PresentMode::immediate:
+      return vkh::PresentMode::immediate;
+    case PresentMode::mailbox:
+      return vkh::PresentMode::mailbox;
+    case PresentMode::fifo_relaxed:
+      return vkh::PresentMode::fifo_relaxed;
+    case PresentMode::fifo:
+      return vkh::PresentMode::fifo;
+    }
+    return vkh::PresentMode::fifo;
+  }
+
+  // one image more than the minimum lets the presentation engine hold a frame while the next one is rendered
+  std::size_t swapchain_image_count() const noexcept {
+    const auto& caps = selected_physical_device_it->get_surface_capabilities().surfaceCapabilities;
+    const auto image_count = caps.minImageCount + 1;
+    return caps.maxImageCount == 0 ? image_count : std::min(image_count, caps.maxImageCount);
   }
 
   void init_swapchain() {
+    swapchain_out_of_date = false;
+    target_width = width;
+    target_height = height;
+    if (width == 0 or height == 0)
+      return;
+
+    present_mode = choose_present_mode();
+
     // clang-format off
-    swapchain = vkh::SwapchainBuilder{*selected_physical_device_it, device, surface}
+    auto new_swapchain = vkh::SwapchainBuilder{*selected_physical_device_it, device, surface}
       .with_extent(width, height)
       .with_required_format(vkh::Format::B8G8R8A8Srgb)
-      .with_present_mode(vkh::PresentMode::fifo)
-      .with_image_count(swapchain_image_count)
+      .with_present_mode(to_vkh(present_mode))
+      .with_image_count(swapchain_image_count())
       .with_usage(vkh::ImageUsageFlagBits::color_attachment_bit | vkh::ImageUsageFlagBits::transfer_dst_bit)
       .with_old_swapchain(swapchain)
       .build();
     // clang-format on
+
+    // the retired swapchain images may still be used by the frames in flight, their framebuffers go first
+    deletion_queue.push(submitted_frame, std::move(swapchain_framebuffers));
+    deletion_queue.push(submitted_frame, std::move(swapchain_image_views));
+    deletion_queue.push(submitted_frame, std::exchange(swapchain, std::move(new_swapchain)));
+
+    swapchain_framebuffers.clear();
+    swapchain_image_views.clear();
+    for (const auto& image : swapchain.get_images()) {
+      swapchain_image_views.emplace_back(
+          vkh::ImageViewBuilder{device, image}.with_format(vkh::Format::B8G8R8A8Srgb).build());
+      swapchain_framebuffers.emplace_back(vkh::FramebufferBuilder{device, render_pass}
+                                              .with_attachment(swapchain_image_views.back())
+                                              .with_extent(target_width, target_height)
+                                              .build());
+    }
+
+    // one present semaphore per image, kept across resizes and only grown when the image count goes up
+    while (rendering_finished_sems.size() < swapchain.get_images().size())
+      rendering_finished_sems.emplace_back(vkh::SemaphoreBuilder{device}.build());
   }
 
   void init_command_pool() {
+    // the buffers have to go back to the pool they came from before the pool is replaced
+    command_buffers = vkh::CommandBuffers{};
+
     // clang-format off
     command_pool = vkh::CommandPoolBuilder{device}
       .with_queue_family_index(present_queue_family_index)
       .with_flags(vkh::CommandPoolCreateFlagBits::reset_command_buffer)
       .build();
 
-    const auto& swapchain_images = swapchain.get_images();
-
+    // one primary per frame in flight, it is re-recorded once the frame timeline says it is free again
     command_buffers = vkh::CommandBuffersBuilder{device, command_pool}
-        .with_buffer_count(swapchain_images.size())
+        .with_buffer_count(frames_in_flight)
+        .build();
+
+    // a frame has at most two draws, far below what is worth splitting: one slot per frame recorded on this thread.
+    // Pass the thread pool once the renderer records long draw lists.
+    recorder = vkh::ParallelRecorderBuilder{device}
+        .with_queue_family_index(present_queue_family_index)
+        .with_frame_count(frames_in_flight)
+        .build();
+
+    // lavapipe and the other CPU implementations write timestamps too, a queue without them only loses the GPU stats
+    gpu_profiler = vkh::GpuProfilerBuilder{*selected_physical_device_it, device}
+        .with_queue_family_index(present_queue_family_index)
+        .with_frame_count(frames_in_flight)
+        .with_pipeline_statistics()
+        .build();
+    // clang-format on
+  }
+
+  void init_offscreen_targets() {
+    target_width = width;
+    target_height = height;
+    offscreen_frames.clear();
+    offscreen_frames.resize(frames_in_flight);
+
+    for (auto& frame : offscreen_frames) {
+      // clang-format off
+      frame.image = vkh::ImageBuilder{device}
+        .with_format(vkh::Format::R8G8B8A8Unorm)
+        .with_extent(target_width, target_height)
+        .with_usage(vkh::ImageUsageFlagBits::color_attachment_bit | vkh::ImageUsageFlagBits::transfer_src_bit)
+        .build();
+
+      frame.image_memory = vkh::DeviceMemoryBuilder{*selected_physical_device_it, device}
+        .with_requirements(frame.image.get_memory_requirements())
+        .with_properties(vkh::MemoryPropertyFlagBits::device_local_bit)
+        .build();
+      frame.image.bind_memory(frame.image_memory);
+
+      frame.image_view = vkh::ImageViewBuilder{device, frame.image}
+        .with_format(vkh::Format::R8G8B8A8Unorm)
+        .build();
+
+      frame.framebuffer = vkh::FramebufferBuilder{device, render_pass}
+        .with_attachment(frame.image_view)
+        .with_extent(target_width, target_height)
+        .build();
+
+      frame.readback_buffer = vkh::BufferBuilder{device}
+        .with_size(readback_size())
+        .with_usage(vkh::BufferUsageFlagBits::transfer_dst_bit)
         .build();
+      // clang-format on
+
+      frame.readback_memory = allocate_readback_memory(frame.readback_buffer.get_memory_requirements());
+      frame.readback_buffer.bind_memory(frame.readback_memory);
+
+      // mapped once here, read_back() only invalidates the range
+      [[maybe_unused]] auto pixels = frame.readback_memory.map();
+    }
+  }
+
+  vkh::DeviceMemory allocate_readback_memory(const VkMemoryRequirements& requirements) {
+    auto builder = vkh::DeviceMemoryBuilder{*selected_physical_device_it, device};
+    builder.with_requirements(requirements);
+
+    // cached memory makes the CPU reads fast, but not every driver exposes it for buffers
+    if (selected_physical_device_it->find_memory_type_index(
+            requirements.memoryTypeBits,
+            vkh::MemoryPropertyFlagBits::host_visible_bit | vkh::MemoryPropertyFlagBits::host_cached_bit))
+      return builder.with_properties(vkh::MemoryPropertyFlagBits::host_visible_bit |
+                                     vkh::MemoryPropertyFlagBits::host_cached_bit)
+          .build();
+
+    return builder.with_properties(vkh::MemoryPropertyFlagBits::host_visible_bit).build();
+  }
+
+  std::size_t readback_size() const noexcept {
+    return static_cast<std::size_t>(target_width) * static_cast<std::size_t>(target_height) * 4uz;
+  }
+
+  // the timeline counts submitted frames, it survives resizes so the values already handed out stay meaningful
+  void init_frame_timeline() {
+    // clang-format off
+    frame_timeline = vkh::SemaphoreBuilder{device}
+      .with_type(vkh::SemaphoreType::timeline)
+      .with_initial_value(0)
+      .build();
+    // clang-format on
+    frame_timeline_values.assign(frames_in_flight, 0);
+  }
+
+  // a single pass clears the target and draws the shapes, it hands the image over ready to present or to copy
+  void init_render_pass() {
+    const auto format = is_headless() ? vkh::Format::R8G8B8A8Unorm : vkh::Format::B8G8R8A8Srgb;
+    const auto final_layout =
+        is_headless() ? vkh::ImageLayout::transfer_src_optimal : vkh::ImageLayout::present_src_khr;
+
+    // clang-format off
+    render_pass = vkh::RenderPassBuilder{device}
+      .with_color_attachment(format, vkh::AttachmentLoadOp::clear, vkh::AttachmentStoreOp::store,
+                             vkh::ImageLayout::undefined, final_layout)
+      .build();
+    // clang-format on
+  }
+
+  void init_shape_pipeline_layout() {
+    // clang-format off
+    shape_pipeline_layout = vkh::PipelineLayoutBuilder{device}
+      .with_push_constant_range(vkh::ShaderStageFlagBits::vertex_bit, 0, sizeof(Affine2D))
+      .build();
+    // clang-format on
+  }
+
+  // only reads the device, the layout and the render pass, so both shape pipelines can be built at the same time
+  vkh::Pipeline build_shape_pipeline(const vkh::ShaderModule& vertex_shader,
+                                     const vkh::ShaderModule& fragment_shader) {
+    using Instance = ShapeBatch::Instance;
+    static_assert(sizeof(Instance) == sizeof(Affine2D) + 4, "The instance attributes must be packed");
+
+    // clang-format off
+    return vkh::GraphicsPipelineBuilder{device, shape_pipeline_layout, render_pass}
+      .with_shader_stage(vkh::ShaderStageFlagBits::vertex_bit, vertex_shader)
+      .with_shader_stage(vkh::ShaderStageFlagBits::fragment_bit, fragment_shader)
+      .with_vertex_binding(0, sizeof(Instance), vkh::VertexInputRate::instance)
+      .with_vertex_attribute(0, 0, vkh::Format::R32G32Sfloat, 0)
+      .with_vertex_attribute(1, 0, vkh::Format::R32G32Sfloat, sizeof(vec2))
+      .with_vertex_attribute(2, 0, vkh::Format::R32G32Sfloat, 2 * sizeof(vec2))
+      .with_vertex_attribute(3, 0, vkh::Format::R8G8B8A8Unorm, sizeof(Affine2D))
+      .with_topology(vkh::PrimitiveTopology::triangle_list)
+      .with_alpha_blending()
+      .build();
     // clang-format on
   }
 
+  // the buffers are allocated by the first frame that has shapes to draw
+  void init_shape_buffers() {
+    shape_buffers.clear();
+    shape_buffers.resize(frames_in_flight);
+  }
+
+  // acquire still needs binary semaphores, one per frame in flight, headless frames only use the timeline
   void init_semaphores() {
     image_availables_sems.clear();
-    rendering_finished_sems.clear();
-    in_flight_fences.clear();
+    if (is_headless())
+      return;
 
-    for (auto i = 0uz; i < swapchain_image_count; ++i) {
+    for (auto i = 0uz; i < frames_in_flight; ++i)
       image_availables_sems.emplace_back(vkh::SemaphoreBuilder{device}.build());
-      rendering_finished_sems.emplace_back(vkh::SemaphoreBuilder{device}.build());
-      in_flight_fences.emplace_back(
-          vkh::FenceBuilder{device}.with_flags(vkh::FenceCreateFlagBits::signaled_bit).build());
-    }
   }
 
-  void record_command_buffer() const {
-    const auto& swapchain_images = swapchain.get_images();
+  void record_frame(std::size_t frame, std::size_t target_index) {
+    auto command_buffer = command_buffers[frame];
+    upload_shapes(frame);
+
+    static const auto begin_record_info = vkh::CommandBufferBeginInfoBuilder{}
+                                              .with_flags(vkh::CommandBufferUsageFlagBits::one_time_submit_bit)
+                                              .build();
+
+    // the secondaries run inside the render pass and inside the pass statistics query, so they inherit both
+    const auto& framebuffer = target_framebuffer(target_index);
+    const auto inheritance_info = vkh::CommandBufferInheritanceInfoBuilder{}
+                                      .with_render_pass(render_pass)
+                                      .with_framebuffer(framebuffer)
+                                      .with_pipeline_statistics(gpu_profiler.pipeline_statistics())
+                                      .build();
+
+    command_buffer.start_recording(begin_record_info);
+
+    // this slot was waited on before being recorded again, so what it measured last time is ready
+    if (gpu_profiler.begin_frame(command_buffer, frame, submitted_frame + 1))
+      update_gpu_stats();
+
+    gpu_profiler.begin_pass(command_buffer, "shapes");
+    command_buffer.begin_render_pass(render_pass, framebuffer, target_width, target_height, clear_color,
+                                     vkh::SubpassContents::secondary_command_buffers);
+
+    // at most two instanced draws whatever the shape count, recorded into one secondary
+    const auto draws = shape_draws(frame_memory.resource());
+    auto secondaries = recorder.record(
+        frame, draws.size(), inheritance_info,
+        [this, frame, &draws](const vkh::CommandBuffer& secondary, std::size_t first, std::size_t last) {
+          secondary.set_viewport(target_width, target_height);
+          secondary.set_scissor(target_width, target_height);
+          secondary.bind_vertex_buffer(0, shape_buffers[frame].buffer);
+          secondary.push_constants(shape_pipeline_layout, vkh::ShaderStageFlagBits::vertex_bit, view_projection);
+
+          for (const auto& draw : std::span{draws}.subspan(first, last - first)) {
+            secondary.bind_pipeline(*draw.pipeline);
+            secondary.draw(6, draw.instance_count, 0, draw.first_instance);
+          }
+        });
+    if (not secondaries.empty())
+      command_buffer.execute_commands(secondaries);
 
-    static const std::vector<vkh::ImageSubresourceRange> subresource_ranges = {
-        vkh::ImageSubresourceRangeBuilder{}.with_aspect_mask(vkh::ImageAspectFlagBits::color_bit).build(),
-    };
+    command_buffer.end_render_pass();
+    gpu_profiler.end_pass(command_buffer);
 
-    for (auto i = 0uz; i < swapchain_images.size(); ++i) {
-      const auto& image = swapchain_images[i];
-      auto command_buffer = command_buffers[i];
-
-      std::vector<vkh::ImageMemoryBarrier> barrier_from_present_to_clear = {
-          vkh::ImageMemoryBarrierBuilder{}
-              .with_src_access_mask(vkh::AccessFlagBits::memory_read_bit)
-              .with_dst_access_mask(vkh::AccessFlagBits::transfer_write_bit)
-              .with_old_layout(vkh::ImageLayout::undefined)
-              .with_new_layout(vkh::ImageLayout::transfer_dst_optimal)
-              .with_src_queue_family_index(present_queue_family_index)
-              .with_dst_queue_family_index(present_queue_family_index)
-              .with_image(image)
-              .with_subresource_range(subresource_ranges.front())
-              .build(),
-      };
+    if (is_headless()) {
+      gpu_profiler.begin_pass(command_buffer, "readback");
+      record_readback(command_buffer, target_index, frame_memory.resource());
+      gpu_profiler.end_pass(command_buffer);
+    }
 
-      std::vector<vkh::ImageMemoryBarrier> barrier_from_clear_to_present = {
-          vkh::ImageMemoryBarrierBuilder{}
-              .with_src_access_mask(vkh::AccessFlagBits::transfer_write_bit)
-              .with_dst_access_mask(vkh::AccessFlagBits::memory_read_bit)
-              .with_old_layout(vkh::ImageLayout::transfer_dst_optimal)
-              .with_new_layout(vkh::ImageLayout::present_src_khr)
-              .with_src_queue_family_index(present_queue_family_index)
-              .with_dst_queue_family_index(present_queue_family_index)
-              .with_image(image)
-              .with_subresource_range(subresource_ranges.front())
-              .build(),
-      };
+    command_buffer.end_recording();
+  }
 
-      static const auto begin_record_info = vkh::CommandBufferBeginInfoBuilder{}
-                                                .with_flags(vkh::CommandBufferUsageFlagBits::simultaneous_use_bit)
-                                                .build();
+  struct ShapeDraw {
+    const vkh::Pipeline* pipeline = nullptr;
+    std::size_t first_instance = 0;
+    std::size_t instance_count = 0;
+  };
 
-      command_buffer.start_recording(begin_record_info);
+  // quads first and circles after them, in the order upload_shapes() wrote them
+  std::pmr::vector<ShapeDraw> shape_draws(std::pmr::memory_resource* resource) const {
+    const auto quad_count = shape_batch.quads().size();
+    const auto circle_count = shape_batch.circles().size();
+
+    std::pmr::vector<ShapeDraw> draws{resource};
+    draws.reserve(2);
+    if (quad_count != 0)
+      draws.push_back(ShapeDraw{&quad_pipeline, 0, quad_count});
+    if (circle_count != 0)
+      draws.push_back(ShapeDraw{&circle_pipeline, quad_count, circle_count});
+    return draws;
+  }
 
-      command_buffer.pipeline_barrier(vkh::PipelineStageFlagBits::transfer_bit,
-                                      vkh::PipelineStageFlagBits::transfer_bit, barrier_from_present_to_clear);
+  // The frame slot is no longer in flight, so its instance buffer can be overwritten or replaced
+  void upload_shapes(std::size_t frame) {
+    auto& shape_buffer = shape_buffers[frame];
+    const auto instance_count = shape_batch.size();
+    if (instance_count == 0)
+      return;
 
-      command_buffer.clear_color(clear_color, image, vkh::ImageLayout::transfer_dst_optimal, subresource_ranges);
+    if (instance_count > shape_buffer.capacity) {
+      shape_buffer.capacity = std::max({instance_count, shape_buffer.capacity * 2, 64uz});
 
-      command_buffer.pipeline_barrier(vkh::PipelineStageFlagBits::transfer_bit,
-                                      vkh::PipelineStageFlagBits::bottomo_of_pipe_bit, barrier_from_clear_to_present);
+      // clang-format off
+      shape_buffer.buffer = vkh::BufferBuilder{device}
+        .with_size(shape_buffer.capacity * sizeof(ShapeBatch::Instance))
+        .with_usage(vkh::BufferUsageFlagBits::vertex_buffer_bit)
+        .build();
 
-      command_buffer.end_recording();
+      shape_buffer.memory = vkh::DeviceMemoryBuilder{*selected_physical_device_it, device}
+        .with_requirements(shape_buffer.buffer.get_memory_requirements())
+        .with_properties(vkh::MemoryPropertyFlagBits::host_visible_bit | vkh::MemoryPropertyFlagBits::host_coherent_bit)
+        .build();
+      // clang-format on
+      shape_buffer.buffer.bind_memory(shape_buffer.memory);
     }
+
+    auto mapped = shape_buffer.memory.map();
+    const auto quad_bytes = std::as_bytes(shape_batch.quads());
+    const auto circle_bytes = std::as_bytes(shape_batch.circles());
+    std::ranges::copy(quad_bytes, mapped.begin());
+    std::ranges::copy(circle_bytes, mapped.begin() + static_cast<std::ptrdiff_t>(quad_bytes.size()));
+  }
+
+  const vkh::Framebuffer& target_framebuffer(std::size_t index) const noexcept {
+    return is_headless() ? offscreen_frames[index].framebuffer : swapchain_framebuffers[index];
+  }
+
+  void update_gpu_stats() {
+    stats.gpu_passes.clear();
+    for (const auto& pass : gpu_profiler.latest())
+      stats.gpu_passes.push_back(GpuPassStats{
+          .name = pass.label,
+          .frame_number = pass.frame_number,
+          .gpu_time = pass.gpu_time,
+          .input_assembly_vertices = pass.input_assembly_vertices,
+          .vertex_shader_invocations = pass.vertex_shader_invocations,
+          .clipping_primitives = pass.clipping_primitives,
+          .fragment_shader_invocations = pass.fragment_shader_invocations,
+      });
+  }
+
+  void record_readback(const vkh::CommandBuffer& command_buffer, std::size_t index,
+                       std::pmr::memory_resource* resource) const {
+    const auto& frame = offscreen_frames[index];
+
+    // the render pass already left the image in transfer_src_optimal, only its writes have to be made visible
+    std::pmr::vector<vkh::ImageMemoryBarrier> barrier_from_render_to_copy{resource};
+    barrier_from_render_to_copy.assign({
+        vkh::ImageMemoryBarrierBuilder{}
+            .with_src_access_mask(vkh::AccessFlagBits::attachment_write_bit)
+            .with_dst_access_mask(vkh::AccessFlagBits::transfer_read_bit)
+            .with_old_layout(vkh::ImageLayout::transfer_src_optimal)
+            .with_new_layout(vkh::ImageLayout::transfer_src_optimal)
+            .with_src_queue_family_index(present_queue_family_index)
+            .with_dst_queue_family_index(present_queue_family_index)
+            .with_image(frame.image)
+            .with_subresource_range(
+                vkh::ImageSubresourceRangeBuilder{}.with_aspect_mask(vkh::ImageAspectFlagBits::color_bit).build())
+            .build(),
+    });
+
+    std::pmr::vector<vkh::MemoryBarrier> barrier_from_copy_to_host{resource};
+    barrier_from_copy_to_host.assign({
+        vkh::MemoryBarrierBuilder{}
+            .with_src_access_mask(vkh::AccessFlagBits::transfer_write_bit)
+            .with_dst_access_mask(vkh::AccessFlagBits::host_read_bit)
+            .build(),
+    });
+
+    command_buffer.pipeline_barrier(vkh::PipelineStageFlagBits::color_attachment_output_bit,
+                                    vkh::PipelineStageFlagBits::transfer_bit, barrier_from_render_to_copy);
+
+    command_buffer.copy_image_to_buffer(frame.image, vkh::ImageLayout::transfer_src_optimal, frame.readback_buffer,
+                                        target_width, target_height);
+
+    command_buffer.pipeline_barrier(vkh::PipelineStageFlagBits::transfer_bit, vkh::PipelineStageFlagBits::host_bit, {},
+                                    barrier_from_copy_to_host, {});
   }
 
 private:
   std::vector<const char*> required_layers;
   std::vector<const char*> required_extensions;
 
+  chrono::StartupTrace& trace = chrono::StartupTrace::global();
+  bool headless = false;
   Window* window = nullptr;
   vkh::Context vk_context;
   vkh::Instance vk_instance{nullptr};
@@ -327,22 +941,77 @@ private:
   vkh::Queue graphic_queue{};
   vkh::Queue present_queue{};
   vkh::Swapchain swapchain{nullptr};
+  vkh::RenderPass render_pass{nullptr};
+  std::vector<vkh::ImageView> swapchain_image_views;
+  std::vector<vkh::Framebuffer> swapchain_framebuffers;
+  vkh::PipelineLayout shape_pipeline_layout{nullptr};
+  vkh::Pipeline quad_pipeline{nullptr};
+  vkh::Pipeline circle_pipeline{nullptr};
   vkh::CommandPool command_pool{nullptr};
+  vis::jobs::ThreadPool thread_pool;
+  vkh::ParallelRecorder recorder{nullptr};
+  vkh::GpuProfiler gpu_profiler{nullptr};
   // per-frame datas
   vkh::CommandBuffers command_buffers{};
   std::vector<vkh::Semaphore> image_availables_sems;
   std::vector<vkh::Semaphore> rendering_finished_sems;
-  std::vector<vkh::Fence> in_flight_fences;
+  vkh::Semaphore frame_timeline{nullptr};
+  std::vector<std::uint64_t> frame_timeline_values;
+  std::uint64_t submitted_frame = 0;
+  std::uint64_t completed_frame = 0;
   std::size_t frame_index = 0;
+  vkh::DeletionQueue deletion_queue;
+  // temporaries of the frame being recorded: draw lists, barriers
+  vis::memory::FrameAllocator frame_memory;
+
+  // one instance buffer per frame in flight, grown when a frame has more shapes than it can hold
+  struct ShapeBuffer {
+    vkh::Buffer buffer{nullptr};
+    vkh::DeviceMemory memory{nullptr};
+    std::size_t capacity = 0;
+  };
+
+  std::vector<ShapeBuffer> shape_buffers;
+  ShapeBatch shape_batch;
+  Affine2D view_projection{};
+
+  // headless targets, one slot per frame in flight
+  struct OffscreenFrame {
+    vkh::Image image{nullptr};
+    vkh::DeviceMemory image_memory{nullptr};
+    vkh::ImageView image_view{nullptr};
+    vkh::Framebuffer framebuffer{nullptr};
+    vkh::Buffer readback_buffer{nullptr};
+    vkh::DeviceMemory readback_memory{nullptr};
+    std::uint64_t frame_number = 0;
+  };
+
+  std::vector<OffscreenFrame> offscreen_frames;
+  std::uint64_t last_read_frame = 0;
+
+  FrameStats stats;
+  std::chrono::nanoseconds total_cpu_time{};
+  std::chrono::nanoseconds pending_wait_time{};
+  bool first_frame_reported = false;
 
   vis::vec4 clear_color{1.0f, 0.0f, 0.0f, 1.0f};
+  // requested extent, and the extent the swapchain or the offscreen ring was built with
   int width = 800;
   int height = 600;
+  int target_width = 0;
+  int target_height = 0;
+  bool swapchain_out_of_date = false;
   std::size_t present_queue_family_index = 0;
-  std::size_t swapchain_image_count = 0;
+  LatencyPolicy latency_policy;
+  PresentMode present_mode = PresentMode::fifo;
+  std::size_t frames_in_flight = 0;
 };
 
-Renderer::Renderer(Window* window) : impl{std::make_unique<Renderer::Impl>(window)} {}
+Renderer::Renderer(Window* window, const LatencyPolicy& latency_policy)
+    : impl{std::make_unique<Renderer::Impl>(window, latency_policy)} {}
+Renderer::Renderer(const std::function<Window*()>& create_window, const LatencyPolicy& latency_policy)
+    : impl{std::make_unique<Renderer::Impl>(create_window, latency_policy)} {}
+Renderer::Renderer(const HeadlessConfig& config) : impl{std::make_unique<Renderer::Impl>(config)} {}
 Renderer::~Renderer() = default;
 
 Renderer::Renderer(Renderer&&) = default;
@@ -353,6 +1022,7 @@ std::string Renderer::show_info() const noexcept {
 }
 
 void Renderer::render() noexcept {
+  memory::AllocationScope allocation_scope{memory::AllocationTag::vk};
   impl->draw();
   // SDL_Vulkan
   // SDL_GL_SwapWindow(*context.window);
@@ -370,4 +1040,36 @@ void Renderer::set_viewport(int x, int y, int width, int height) noexcept {
   impl->set_viewport(x, y, width, height);
 }
 
+ShapeBatch& Renderer::shapes() noexcept {
+  return impl->shapes();
+}
+
+void Renderer::set_view_projection(const Affine2D& view_projection) noexcept {
+  impl->set_view_projection(view_projection);
+}
+
+void Renderer::set_latency_policy(const LatencyPolicy& latency_policy) {
+  impl->set_latency_policy(latency_policy);
+}
+
+PresentMode Renderer::present_mode() const noexcept {
+  return impl->get_present_mode();
+}
+
+void Renderer::wait_for_next_frame() noexcept {
+  impl->wait_for_next_frame();
+}
+
+bool Renderer::is_headless() const noexcept {
+  return impl->is_headless();
+}
+
+std::optional<ReadbackImage> Renderer::read_back() noexcept {
+  return impl->read_back();
+}
+
+FrameStats Renderer::frame_stats() const noexcept {
+  return impl->frame_stats();
+}
+
 } // namespace vis::vulkan
\ No newline at end of file
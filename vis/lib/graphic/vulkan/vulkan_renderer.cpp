@@ -3,13 +3,144 @@ export module vis.graphic.vulkan;
 import std;
 import vis.window;
 import vis.math;
+import vis.chrono;
 
 export namespace vis::vulkan {
 
+// Renders into a ring of offscreen images instead of a swapchain, no window or display is needed
+struct HeadlessConfig {
+  int width = 800;
+  int height = 600;
+  std::size_t ring_size = 3;
+};
+
+// Pixels are tightly packed R8G8B8A8 rows and stay valid until render() reuses the ring slot
+struct ReadbackImage {
+  std::uint64_t frame_number = 0;
+  int width = 0;
+  int height = 0;
+  std::span<const std::byte> pixels;
+};
+
+enum class PresentMode {
+  immediate,
+  mailbox,
+  fifo_relaxed,
+  fifo,
+};
+
+// How frames are presented and how far the CPU may run ahead of the GPU
+struct LatencyPolicy {
+  // tried in order against what the surface supports, fifo is always available and is the last resort
+  std::vector<PresentMode> present_modes{PresentMode::fifo};
+  std::size_t frames_in_flight = 2;
+
+  // tearing allowed, a single frame queued: the shortest input to photon path
+  static LatencyPolicy low_latency() {
+    return {
+        .present_modes = {PresentMode::mailbox, PresentMode::immediate, PresentMode::fifo_relaxed},
+        .frames_in_flight = 1,
+    };
+  }
+
+  // vsync paced, the CPU sleeps in wait_for_next_frame instead of rendering frames nobody sees
+  static LatencyPolicy power_saving() {
+    return {
+        .present_modes = {PresentMode::fifo},
+        .frames_in_flight = 2,
+    };
+  }
+};
+
+// Rectangles, lines and circles of one frame. They are packed into a single instance stream that the renderer draws
+// with one instanced draw for the quads and one for the circles, however many shapes there are.
+class ShapeBatch {
+public:
+  // Matches the instance attributes of shape2d.vert, 28 bytes
+  struct Instance {
+    // maps the [-1, 1] quad to the world, the half extent included
+    Affine2D model;
+    // RGBA8, the vertex fetch turns it back into floats
+    std::array<std::uint8_t, 4> color;
+  };
+
+  void add_rectangle(vec2 center, vec2 half_extent, vec4 color, vec2 rotation = {1.0f, 0.0f}) {
+    quad_instances.push_back(Instance{Affine2D::from_trs(center, rotation, half_extent), pack(color)});
+  }
+
+  // A line is a rectangle stretched between its end points
+  void add_line(vec2 from, vec2 to, float thickness, vec4 color) {
+    const auto delta = to - from;
+    const auto length = std::hypot(delta.x, delta.y);
+    const auto rotation = length > 0.0f ? delta / length : vec2{1.0f, 0.0f};
+    const auto model = Affine2D::from_trs((from + to) * 0.5f, rotation, vec2{length, thickness} * 0.5f);
+    quad_instances.push_back(Instance{model, pack(color)});
+  }
+
+  // Drawn as a quad whose fragment shader keeps what is inside the circle, the edge is antialiased
+  void add_circle(vec2 center, float radius, vec4 color) {
+    const auto model = Affine2D::from_trs(center, vec2{1.0f, 0.0f}, vec2{radius, radius});
+    circle_instances.push_back(Instance{model, pack(color)});
+  }
+
+  void clear() noexcept {
+    quad_instances.clear();
+    circle_instances.clear();
+  }
+
+  [[nodiscard]] std::span<const Instance> quads() const noexcept {
+    return quad_instances;
+  }
+
+  [[nodiscard]] std::span<const Instance> circles() const noexcept {
+    return circle_instances;
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept {
+    return quad_instances.size() + circle_instances.size();
+  }
+
+private:
+  static std::array<std::uint8_t, 4> pack(vec4 color) noexcept {
+    const auto to_byte = [](float channel) {
+      return static_cast<std::uint8_t>(std::lround(std::clamp(channel, 0.0f, 1.0f) * 255.0f));
+    };
+    return {to_byte(color.r), to_byte(color.g), to_byte(color.b), to_byte(color.a)};
+  }
+
+  std::vector<Instance> quad_instances;
+  std::vector<Instance> circle_instances;
+};
+
+struct GpuPassStats {
+  std::string name;
+  std::uint64_t frame_number = 0;
+  chrono::milliseconds gpu_time{};
+  // stay zero when the device cannot count pipeline statistics
+  std::uint64_t input_assembly_vertices = 0;
+  std::uint64_t vertex_shader_invocations = 0;
+  std::uint64_t clipping_primitives = 0;
+  std::uint64_t fragment_shader_invocations = 0;
+};
+
+struct FrameStats {
+  std::uint64_t frame_count = 0;
+  chrono::milliseconds last_cpu_time{};
+  chrono::milliseconds average_cpu_time{};
+  chrono::milliseconds last_wait_time{};
+  // GPU cost per pass of an older frame, GPU results are read back without waiting so they lag a few frames behind.
+  // Empty when the device cannot write timestamps.
+  std::vector<GpuPassStats> gpu_passes;
+};
+
 class Renderer {
 public:
   // static std::expected<Renderer, std::string> create(Window* window);
-  explicit Renderer(Window* window);
+  explicit Renderer(Window* window, const LatencyPolicy& latency_policy = {});
+  // Calls create_window on this thread while the instance is created and the shaders are read on worker threads. The
+  // window must outlive the renderer.
+  explicit Renderer(const std::function<Window*()>& create_window, const LatencyPolicy& latency_policy = {});
+  explicit Renderer(const HeadlessConfig& config);
 
   Renderer(Renderer&&);
   Renderer& operator=(Renderer&&);
@@ -26,8 +157,31 @@ public:
   void set_viewport([[maybe_unused]] int x, [[maybe_unused]] int y, [[maybe_unused]] int width,
                     [[maybe_unused]] int height) noexcept;
 
+  // Shapes drawn by the next render(), which uploads them and clears the batch
+  [[nodiscard]] ShapeBatch& shapes() noexcept;
+
+  // World to clip space transform of the shapes, with the OpenGL conventions of vis::orthogonal_matrix
+  void set_view_projection(const Affine2D& view_projection) noexcept;
+
   std::string show_info() const noexcept;
 
+  // Takes effect from the next render(), the headless renderer keeps the ring size it was created with. A new frames in
+  // flight count rebuilds the per-frame objects and throws when Vulkan cannot create them.
+  void set_latency_policy(const LatencyPolicy& latency_policy);
+  [[nodiscard]] PresentMode present_mode() const noexcept;
+
+  // Blocks until the next frame slot is free on the GPU. Called right after render() and before input is polled, it
+  // moves the throttling wait in front of the simulation so the next frame samples input as late as possible.
+  void wait_for_next_frame() noexcept;
+
+  [[nodiscard]] bool is_headless() const noexcept;
+
+  // Returns the most recent headless frame the GPU finished and that was not read yet, it never blocks
+  [[nodiscard]] std::optional<ReadbackImage> read_back() noexcept;
+
+  // CPU time spent inside render(), waits on the GPU are reported apart, next to the GPU time of every pass
+  [[nodiscard]] FrameStats frame_stats() const noexcept;
+
 private:
   class Impl;
   std::unique_ptr<Impl> impl;
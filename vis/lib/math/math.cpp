@@ -2698,8 +2698,84 @@ export {
 }
 
 export namespace vis {
+// A 2D affine transform, the upper 2x3 part of a mat3: a point p goes to x_axis * p.x + y_axis * p.y + translation.
+// 24 bytes where a mat4 takes 64, laid out as a GLSL mat3x2 so it is uploaded as is.
+struct Affine2D {
+	vec2 x_axis{1.0f, 0.0f};
+	vec2 y_axis{0.0f, 1.0f};
+	vec2 translation{};
+
+	// Scales, then rotates by the angle whose cosine and sine are rotation, then translates
+	[[nodiscard]] static Affine2D from_trs(vec2 translation, vec2 rotation, vec2 scale) noexcept {
+		return {
+				.x_axis = rotation * scale.x,
+				.y_axis = vec2{-rotation.y, rotation.x} * scale.y,
+				.translation = translation,
+		};
+	}
+
+	// Maps [left, right] x [bottom, top] to [-1, 1] x [-1, 1], the x and y part of ext::ortho
+	[[nodiscard]] static Affine2D ortho(float left, float right, float bottom, float top) noexcept {
+		return {
+				.x_axis = {2.0f / (right - left), 0.0f},
+				.y_axis = {0.0f, 2.0f / (top - bottom)},
+				.translation = {-(right + left) / (right - left), -(top + bottom) / (top - bottom)},
+		};
+	}
+
+	[[nodiscard]] vec2 apply(vec2 point) const noexcept {
+		return x_axis * point.x + y_axis * point.y + translation;
+	}
+
+	// Directions are not translated
+	[[nodiscard]] vec2 apply_vector(vec2 direction) const noexcept {
+		return x_axis * direction.x + y_axis * direction.y;
+	}
+
+	// rhs applies first, then this transform
+	[[nodiscard]] Affine2D compose(const Affine2D& rhs) const noexcept {
+		return {
+				.x_axis = apply_vector(rhs.x_axis),
+				.y_axis = apply_vector(rhs.y_axis),
+				.translation = apply(rhs.translation),
+		};
+	}
+
+	// The transform must not collapse the plane, a zero determinant has no inverse
+	[[nodiscard]] Affine2D inverse() const noexcept {
+		const auto inverse_determinant = 1.0f / (x_axis.x * y_axis.y - y_axis.x * x_axis.y);
+		const auto inverse_x_axis = vec2{y_axis.y, -x_axis.y} * inverse_determinant;
+		const auto inverse_y_axis = vec2{-y_axis.x, x_axis.x} * inverse_determinant;
+		return {
+				.x_axis = inverse_x_axis,
+				.y_axis = inverse_y_axis,
+				.translation = -(inverse_x_axis * translation.x + inverse_y_axis * translation.y),
+		};
+	}
+
+	[[nodiscard]] mat3 to_mat3() const noexcept {
+		return mat3{vec3{x_axis, 0.0f}, vec3{y_axis, 0.0f}, vec3{translation, 1.0f}};
+	}
+
+	// For the APIs that still want a 4x4 matrix, z is left alone
+	[[nodiscard]] mat4 to_mat4() const noexcept {
+		return mat4{
+				vec4{x_axis, 0.0f, 0.0f},
+				vec4{y_axis, 0.0f, 0.0f},
+				vec4{0.0f, 0.0f, 1.0f, 0.0f},
+				vec4{translation, 0.0f, 1.0f},
+		};
+	}
+
+	friend Affine2D operator*(const Affine2D& lhs, const Affine2D& rhs) noexcept {
+		return lhs.compose(rhs);
+	}
+};
+
+static_assert(sizeof(Affine2D) == 6 * sizeof(float), "Affine2D must match the layout of a GLSL mat3x2");
+
 struct ScreenProjection {
-	vis::mat4 projection;
+	vis::Affine2D projection;
 	vis::vec2 half_world_extent;
 };
 
@@ -2709,8 +2785,6 @@ ScreenProjection orthogonal_matrix(int screen_width, int screen_height, float wo
 	float right = world_width / 2.0f;
 	float bottom = -world_height / 2.0f;
 	float top = world_height / 2.0f;
-	const float near = -1.0f;
-	const float far = 1.0f;
 
 	if (ratio > 1.0f) { // Screen is wider than the world aspect (1:1)
 		// Adjust the world width to match the screen aspect
@@ -2725,7 +2799,7 @@ ScreenProjection orthogonal_matrix(int screen_width, int screen_height, float wo
 	}
 
 	return {
-			.projection = vis::ext::ortho(left, right, bottom, top, near, far),
+			.projection = vis::Affine2D::ortho(left, right, bottom, top),
 			.half_world_extent = vis::vec2{world_width / 2.0f, world_height / 2.0f},
 	};
 }
@@ -0,0 +1,595 @@
+module;
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VIS_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VIS_SIMD_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define VIS_SIMD_NEON
+#endif
+
+export module vis.math.simd;
+
+import std;
+import vis.math;
+import vis.chrono;
+
+// non exported
+namespace vis::simd {
+
+struct ScalarLanes {
+	using type = float;
+	static constexpr std::size_t width = 1;
+
+	static type load(const float* source) {
+		return *source;
+	}
+
+	static void store(float* target, type value) {
+		*target = value;
+	}
+
+	static type splat(float value) {
+		return value;
+	}
+
+	static type add(type a, type b) {
+		return a + b;
+	}
+
+	static type sub(type a, type b) {
+		return a - b;
+	}
+
+	static type mul(type a, type b) {
+		return a * b;
+	}
+
+	static type min(type a, type b) {
+		return std::min(a, b);
+	}
+
+	static type max(type a, type b) {
+		return std::max(a, b);
+	}
+
+	// 1 / sqrt(length_squared), zero for a zero length
+	static type inverse_length(type length_squared) {
+		return length_squared > 0.0f ? 1.0f / std::sqrt(length_squared) : 0.0f;
+	}
+};
+
+#if defined(VIS_SIMD_AVX2)
+struct NativeLanes {
+	using type = __m256;
+	static constexpr std::size_t width = 8;
+
+	static type load(const float* source) {
+		return _mm256_loadu_ps(source);
+	}
+
+	static void store(float* target, type value) {
+		_mm256_storeu_ps(target, value);
+	}
+
+	static type splat(float value) {
+		return _mm256_set1_ps(value);
+	}
+
+	static type add(type a, type b) {
+		return _mm256_add_ps(a, b);
+	}
+
+	static type sub(type a, type b) {
+		return _mm256_sub_ps(a, b);
+	}
+
+	static type mul(type a, type b) {
+		return _mm256_mul_ps(a, b);
+	}
+
+	static type min(type a, type b) {
+		return _mm256_min_ps(a, b);
+	}
+
+	static type max(type a, type b) {
+		return _mm256_max_ps(a, b);
+	}
+
+	static type inverse_length(type length_squared) {
+		const auto non_zero = _mm256_cmp_ps(length_squared, _mm256_setzero_ps(), _CMP_GT_OQ);
+		return _mm256_and_ps(non_zero, _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(length_squared)));
+	}
+};
+#elif defined(VIS_SIMD_SSE2)
+struct NativeLanes {
+	using type = __m128;
+	static constexpr std::size_t width = 4;
+
+	static type load(const float* source) {
+		return _mm_loadu_ps(source);
+	}
+
+	static void store(float* target, type value) {
+		_mm_storeu_ps(target, value);
+	}
+
+	static type splat(float value) {
+		return _mm_set1_ps(value);
+	}
+
+	static type add(type a, type b) {
+		return _mm_add_ps(a, b);
+	}
+
+	static type sub(type a, type b) {
+		return _mm_sub_ps(a, b);
+	}
+
+	static type mul(type a, type b) {
+		return _mm_mul_ps(a, b);
+	}
+
+	static type min(type a, type b) {
+		return _mm_min_ps(a, b);
+	}
+
+	static type max(type a, type b) {
+		return _mm_max_ps(a, b);
+	}
+
+	static type inverse_length(type length_squared) {
+		const auto non_zero = _mm_cmpgt_ps(length_squared, _mm_setzero_ps());
+		return _mm_and_ps(non_zero, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length_squared)));
+	}
+};
+#elif defined(VIS_SIMD_NEON)
+struct NativeLanes {
+	using type = float32x4_t;
+	static constexpr std::size_t width = 4;
+
+	static type load(const float* source) {
+		return vld1q_f32(source);
+	}
+
+	static void store(float* target, type value) {
+		vst1q_f32(target, value);
+	}
+
+	static type splat(float value) {
+		return vdupq_n_f32(value);
+	}
+
+	static type add(type a, type b) {
+		return vaddq_f32(a, b);
+	}
+
+	static type sub(type a, type b) {
+		return vsubq_f32(a, b);
+	}
+
+	static type mul(type a, type b) {
+		return vmulq_f32(a, b);
+	}
+
+	static type min(type a, type b) {
+		return vminq_f32(a, b);
+	}
+
+	static type max(type a, type b) {
+		return vmaxq_f32(a, b);
+	}
+
+	static type inverse_length(type length_squared) {
+		const auto non_zero = vcgtq_f32(length_squared, vdupq_n_f32(0.0f));
+		const auto inverse = vdivq_f32(vdupq_n_f32(1.0f), vsqrtq_f32(length_squared));
+		return vreinterpretq_f32_u32(vandq_u32(non_zero, vreinterpretq_u32_f32(inverse)));
+	}
+};
+#else
+using NativeLanes = ScalarLanes;
+#endif
+
+// Calls kernel.operator()<Lanes>(index) with full native lanes from index on, then with scalar lanes for the tail
+template <typename Kernel> void for_lanes(std::size_t count, Kernel&& kernel) {
+	auto index = 0uz;
+	for (; index + NativeLanes::width <= count; index += NativeLanes::width)
+		kernel.template operator()<NativeLanes>(index);
+	for (; index != count; ++index)
+		kernel.template operator()<ScalarLanes>(index);
+}
+
+void check_size(std::size_t expected, std::size_t actual) {
+	if (expected != actual)
+		throw std::invalid_argument{std::format("The batches hold {} and {} elements", expected, actual)};
+}
+
+template <typename Fn> chrono::microseconds measure(int repetitions, Fn&& fn) {
+	const auto start = std::chrono::steady_clock::now();
+	for (auto i = 0; i != repetitions; ++i)
+		fn();
+	return chrono::microseconds{std::chrono::steady_clock::now() - start} / static_cast<float>(repetitions);
+}
+
+} // namespace vis::simd
+
+export namespace vis::simd {
+
+enum class Isa { scalar, sse2, avx2, neon };
+
+// Picked at compile time from the target of the build: AVX2 needs WITH_AVX2, SSE2 is there on every x86-64
+#if defined(VIS_SIMD_AVX2)
+constexpr Isa isa = Isa::avx2;
+#elif defined(VIS_SIMD_SSE2)
+constexpr Isa isa = Isa::sse2;
+#elif defined(VIS_SIMD_NEON)
+constexpr Isa isa = Isa::neon;
+#else
+constexpr Isa isa = Isa::scalar;
+#endif
+
+constexpr std::size_t lane_count = NativeLanes::width;
+
+constexpr std::string_view to_string(Isa value) {
+	switch (value) {
+	case Isa::scalar:
+		return "scalar";
+	case Isa::sse2:
+		return "SSE2";
+	case Isa::avx2:
+		return "AVX2";
+	case Isa::neon:
+		return "NEON";
+	}
+	return "unknown";
+}
+
+// Batches are structures of arrays, element i of a Vec2Batch is {x[i], y[i]}, so the kernels load lane_count elements
+// of one component at once. Keep the batches around: the kernels resize their output, which stops allocating once it
+// has grown to the largest batch.
+struct Vec2Batch {
+	std::vector<float> x;
+	std::vector<float> y;
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return x.size();
+	}
+
+	void resize(std::size_t count) {
+		x.resize(count);
+		y.resize(count);
+	}
+
+	void clear() noexcept {
+		x.clear();
+		y.clear();
+	}
+
+	void push_back(vec2 value) {
+		x.push_back(value.x);
+		y.push_back(value.y);
+	}
+
+	[[nodiscard]] vec2 operator[](std::size_t index) const noexcept {
+		return {x[index], y[index]};
+	}
+
+	void set(std::size_t index, vec2 value) noexcept {
+		x[index] = value.x;
+		y[index] = value.y;
+	}
+};
+
+// Cosine and sine of each rotation angle
+struct RotationBatch {
+	std::vector<float> cos;
+	std::vector<float> sin;
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return cos.size();
+	}
+
+	void resize(std::size_t count) {
+		cos.resize(count);
+		sin.resize(count);
+	}
+
+	void clear() noexcept {
+		cos.clear();
+		sin.clear();
+	}
+
+	void push_back(vec2 cos_sin) {
+		cos.push_back(cos_sin.x);
+		sin.push_back(cos_sin.y);
+	}
+
+	[[nodiscard]] vec2 operator[](std::size_t index) const noexcept {
+		return {cos[index], sin[index]};
+	}
+};
+
+// Affine2D split by component: {a, b} is the x axis, {c, d} the y axis and {tx, ty} the translation, so a point p goes
+// to {a * p.x + c * p.y + tx, b * p.x + d * p.y + ty}.
+struct AffineBatch {
+	std::vector<float> a;
+	std::vector<float> b;
+	std::vector<float> c;
+	std::vector<float> d;
+	std::vector<float> tx;
+	std::vector<float> ty;
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return a.size();
+	}
+
+	void resize(std::size_t count) {
+		for (auto* component : {&a, &b, &c, &d, &tx, &ty})
+			component->resize(count);
+	}
+
+	void clear() noexcept {
+		for (auto* component : {&a, &b, &c, &d, &tx, &ty})
+			component->clear();
+	}
+
+	void push_back(const Affine2D& transform) {
+		a.push_back(transform.x_axis.x);
+		b.push_back(transform.x_axis.y);
+		c.push_back(transform.y_axis.x);
+		d.push_back(transform.y_axis.y);
+		tx.push_back(transform.translation.x);
+		ty.push_back(transform.translation.y);
+	}
+
+	[[nodiscard]] Affine2D operator[](std::size_t index) const noexcept {
+		return {
+				.x_axis = {a[index], b[index]},
+				.y_axis = {c[index], d[index]},
+				.translation = {tx[index], ty[index]},
+		};
+	}
+};
+
+// Affine2D::from_trs() element by element: the model transforms of RigidBody::get_model() and
+// render::model_transform() for a whole batch of bodies
+void make_affines(const Vec2Batch& positions, const RotationBatch& rotations, const Vec2Batch& scales,
+									AffineBatch& out) {
+	const auto count = positions.size();
+	check_size(count, rotations.size());
+	check_size(count, scales.size());
+	out.resize(count);
+	for_lanes(count, [&]<typename L>(std::size_t i) {
+		const auto cos_angle = L::load(rotations.cos.data() + i);
+		const auto sin_angle = L::load(rotations.sin.data() + i);
+		const auto sx = L::load(scales.x.data() + i);
+		const auto sy = L::load(scales.y.data() + i);
+		L::store(out.a.data() + i, L::mul(cos_angle, sx));
+		L::store(out.b.data() + i, L::mul(sin_angle, sx));
+		L::store(out.c.data() + i, L::mul(L::sub(L::splat(0.0f), sin_angle), sy));
+		L::store(out.d.data() + i, L::mul(cos_angle, sy));
+		L::store(out.tx.data() + i, L::load(positions.x.data() + i));
+		L::store(out.ty.data() + i, L::load(positions.y.data() + i));
+	});
+}
+
+// out[i] = lhs[i] * rhs[i], rhs applies first. out may be lhs or rhs.
+void compose(const AffineBatch& lhs, const AffineBatch& rhs, AffineBatch& out) {
+	const auto count = lhs.size();
+	check_size(count, rhs.size());
+	out.resize(count);
+	for_lanes(count, [&]<typename L>(std::size_t i) {
+		const auto la = L::load(lhs.a.data() + i), lb = L::load(lhs.b.data() + i);
+		const auto lc = L::load(lhs.c.data() + i), ld = L::load(lhs.d.data() + i);
+		const auto ltx = L::load(lhs.tx.data() + i), lty = L::load(lhs.ty.data() + i);
+		const auto ra = L::load(rhs.a.data() + i), rb = L::load(rhs.b.data() + i);
+		const auto rc = L::load(rhs.c.data() + i), rd = L::load(rhs.d.data() + i);
+		const auto rtx = L::load(rhs.tx.data() + i), rty = L::load(rhs.ty.data() + i);
+		L::store(out.a.data() + i, L::add(L::mul(la, ra), L::mul(lc, rb)));
+		L::store(out.b.data() + i, L::add(L::mul(lb, ra), L::mul(ld, rb)));
+		L::store(out.c.data() + i, L::add(L::mul(la, rc), L::mul(lc, rd)));
+		L::store(out.d.data() + i, L::add(L::mul(lb, rc), L::mul(ld, rd)));
+		L::store(out.tx.data() + i, L::add(L::add(L::mul(la, rtx), L::mul(lc, rty)), ltx));
+		L::store(out.ty.data() + i, L::add(L::add(L::mul(lb, rtx), L::mul(ld, rty)), lty));
+	});
+}
+
+// out[i] = lhs * rhs[i], a view projection applied to every model transform. out may be rhs.
+void compose(const Affine2D& lhs, const AffineBatch& rhs, AffineBatch& out) {
+	const auto count = rhs.size();
+	out.resize(count);
+	for_lanes(count, [&]<typename L>(std::size_t i) {
+		const auto la = L::splat(lhs.x_axis.x), lb = L::splat(lhs.x_axis.y);
+		const auto lc = L::splat(lhs.y_axis.x), ld = L::splat(lhs.y_axis.y);
+		const auto ltx = L::splat(lhs.translation.x), lty = L::splat(lhs.translation.y);
+		const auto ra = L::load(rhs.a.data() + i), rb = L::load(rhs.b.data() + i);
+		const auto rc = L::load(rhs.c.data() + i), rd = L::load(rhs.d.data() + i);
+		const auto rtx = L::load(rhs.tx.data() + i), rty = L::load(rhs.ty.data() + i);
+		L::store(out.a.data() + i, L::add(L::mul(la, ra), L::mul(lc, rb)));
+		L::store(out.b.data() + i, L::add(L::mul(lb, ra), L::mul(ld, rb)));
+		L::store(out.c.data() + i, L::add(L::mul(la, rc), L::mul(lc, rd)));
+		L::store(out.d.data() + i, L::add(L::mul(lb, rc), L::mul(ld, rd)));
+		L::store(out.tx.data() + i, L::add(L::add(L::mul(la, rtx), L::mul(lc, rty)), ltx));
+		L::store(out.ty.data() + i, L::add(L::add(L::mul(lb, rtx), L::mul(ld, rty)), lty));
+	});
+}
+
+// out[i] = transforms[i] applied to points[i]. out may be points.
+void transform_points(const AffineBatch& transforms, const Vec2Batch& points, Vec2Batch& out) {
+	const auto count = points.size();
+	check_size(count, transforms.size());
+	out.resize(count);
+	for_lanes(count, [&]<typename L>(std::size_t i) {
+		const auto x = L::load(points.x.data() + i);
+		const auto y = L::load(points.y.data() + i);
+		const auto a = L::load(transforms.a.data() + i), b = L::load(transforms.b.data() + i);
+		const auto c = L::load(transforms.c.data() + i), d = L::load(transforms.d.data() + i);
+		L::store(out.x.data() + i, L::add(L::add(L::mul(a, x), L::mul(c, y)), L::load(transforms.tx.data() + i)));
+		L::store(out.y.data() + i, L::add(L::add(L::mul(b, x), L::mul(d, y)), L::load(transforms.ty.data() + i)));
+	});
+}
+
+// out[i] = transform applied to points[i], the vertices of one shape. out may be points.
+void transform_points(const Affine2D& transform, const Vec2Batch& points, Vec2Batch& out) {
+	const auto count = points.size();
+	out.resize(count);
+	for_lanes(count, [&]<typename L>(std::size_t i) {
+		const auto x = L::load(points.x.data() + i);
+		const auto y = L::load(points.y.data() + i);
+		const auto a = L::splat(transform.x_axis.x), b = L::splat(transform.x_axis.y);
+		const auto c = L::splat(transform.y_axis.x), d = L::splat(transform.y_axis.y);
+		L::store(out.x.data() + i, L::add(L::add(L::mul(a, x), L::mul(c, y)), L::splat(transform.translation.x)));
+		L::store(out.y.data() + i, L::add(L::add(L::mul(b, x), L::mul(d, y)), L::splat(transform.translation.y)));
+	});
+}
+
+// Zero vectors stay zero instead of turning into NaNs. out may be vectors.
+void normalize(const Vec2Batch& vectors, Vec2Batch& out) {
+	const auto count = vectors.size();
+	out.resize(count);
+	for_lanes(count, [&]<typename L>(std::size_t i) {
+		const auto x = L::load(vectors.x.data() + i);
+		const auto y = L::load(vectors.y.data() + i);
+		const auto inverse_length = L::inverse_length(L::add(L::mul(x, x), L::mul(y, y)));
+		L::store(out.x.data() + i, L::mul(x, inverse_length));
+		L::store(out.y.data() + i, L::mul(y, inverse_length));
+	});
+}
+
+// Component wise, into [min, max]. out may be vectors.
+void clamp(const Vec2Batch& vectors, vec2 min, vec2 max, Vec2Batch& out) {
+	const auto count = vectors.size();
+	out.resize(count);
+	for_lanes(count, [&]<typename L>(std::size_t i) {
+		const auto x = L::load(vectors.x.data() + i);
+		const auto y = L::load(vectors.y.data() + i);
+		L::store(out.x.data() + i, L::min(L::max(x, L::splat(min.x)), L::splat(max.x)));
+		L::store(out.y.data() + i, L::min(L::max(y, L::splat(min.y)), L::splat(max.y)));
+	});
+}
+
+struct BatchMathBenchmark {
+	std::string_view kernel;
+	// glm, one element at a time
+	chrono::microseconds scalar;
+	chrono::microseconds batched;
+};
+
+// Average cost of each kernel over count random elements, against the per element glm code it replaces: the mat4
+// models RigidBody::get_model() used to build, the mat4 view_projection * model products of the OpenGL backend and
+// mat4 * vec4 for the points. An empty batch has nothing to measure and gives no results.
+std::vector<BatchMathBenchmark> benchmark_batch_math(std::size_t count = 4096, int repetitions = 100) {
+	if (repetitions <= 0)
+		throw std::invalid_argument{std::format("Cannot average over {} repetitions", repetitions)};
+	if (count == 0)
+		return {};
+
+	std::mt19937 random{42};
+	std::uniform_real_distribution<float> distribution{-10.0f, 10.0f};
+
+	Vec2Batch positions, scales, points, vectors_out;
+	RotationBatch rotations;
+	for (auto i = 0uz; i != count; ++i) {
+		positions.push_back(vec2{distribution(random), distribution(random)});
+		scales.push_back(vec2{distribution(random), distribution(random)});
+		points.push_back(vec2{distribution(random), distribution(random)});
+		const auto angle = distribution(random);
+		rotations.push_back(vec2{std::cos(angle), std::sin(angle)});
+	}
+	const auto view = Affine2D::ortho(-2.0f, 2.0f, -1.5f, 1.5f);
+	const auto view_projection = view.to_mat4();
+
+	AffineBatch models, products;
+	std::vector<mat4> scalar_models(count);
+	std::vector<mat4> scalar_products(count);
+	std::vector<vec2> scalar_points(count);
+	// read after each run, so the optimizer keeps the loops
+	volatile float sink = 0.0f;
+
+	std::vector<BatchMathBenchmark> results;
+	results.push_back(BatchMathBenchmark{
+			.kernel = "make_affines",
+			.scalar = measure(repetitions,
+												[&] {
+													for (auto i = 0uz; i != count; ++i) {
+														const auto rotation = rotations[i];
+														const auto c = rotation.x;
+														const auto s = rotation.y;
+														const auto scale = scales[i];
+														auto model = mat4{1.0f};
+														model[0] = vec4{c * scale.x, s * scale.x, 0.0f, 0.0f};
+														model[1] = vec4{-s * scale.y, c * scale.y, 0.0f, 0.0f};
+														model[3] = vec4{positions[i], 0.0f, 1.0f};
+														scalar_models[i] = model;
+													}
+													sink = scalar_models.back()[3][0];
+												}),
+			.batched = measure(repetitions,
+												 [&] {
+													 make_affines(positions, rotations, scales, models);
+													 sink = models.tx.back();
+												 }),
+	});
+	results.push_back(BatchMathBenchmark{
+			.kernel = "compose",
+			.scalar = measure(repetitions,
+												[&] {
+													for (auto i = 0uz; i != count; ++i)
+														scalar_products[i] = view_projection * scalar_models[i];
+													sink = scalar_products.back()[3][0];
+												}),
+			.batched = measure(repetitions,
+												 [&] {
+													 compose(view, models, products);
+													 sink = products.tx.back();
+												 }),
+	});
+	results.push_back(BatchMathBenchmark{
+			.kernel = "transform_points",
+			.scalar = measure(repetitions,
+												[&] {
+													for (auto i = 0uz; i != count; ++i)
+														scalar_points[i] = vec2{scalar_models[i] * vec4{points[i], 0.0f, 1.0f}};
+													sink = scalar_points.back().x;
+												}),
+			.batched = measure(repetitions,
+												 [&] {
+													 transform_points(models, points, vectors_out);
+													 sink = vectors_out.x.back();
+												 }),
+	});
+	results.push_back(BatchMathBenchmark{
+			.kernel = "normalize",
+			.scalar = measure(repetitions,
+												[&] {
+													for (auto i = 0uz; i != count; ++i)
+														scalar_points[i] = vis::normalize(points[i]);
+													sink = scalar_points.back().x;
+												}),
+			.batched = measure(repetitions,
+												 [&] {
+													 normalize(points, vectors_out);
+													 sink = vectors_out.x.back();
+												 }),
+	});
+	results.push_back(BatchMathBenchmark{
+			.kernel = "clamp",
+			.scalar = measure(repetitions,
+												[&] {
+													for (auto i = 0uz; i != count; ++i)
+														scalar_points[i] = vis::clamp(points[i], vec2{-1.0f}, vec2{1.0f});
+													sink = scalar_points.back().x;
+												}),
+			.batched = measure(repetitions,
+												 [&] {
+													 clamp(points, vec2{-1.0f}, vec2{1.0f}, vectors_out);
+													 sink = vectors_out.x.back();
+												 }),
+	});
+	return results;
+}
+
+} // namespace vis::simd
@@ -0,0 +1,371 @@
+export module vis.net;
+
+import std;
+import vis.chrono;
+import vis.replay;
+
+export namespace vis::net {
+
+using Packet = std::vector<std::byte>;
+
+// Unreliable datagrams, like UDP: a packet may arrive late, out of order or never
+class Transport {
+public:
+	virtual ~Transport() = default;
+
+	virtual void send(std::span<const std::byte> packet) = 0;
+	// The next packet that arrived, or nothing. It never blocks.
+	[[nodiscard]] virtual std::optional<Packet> receive() = 0;
+};
+
+struct LinkConditions {
+	chrono::milliseconds latency{};
+	// each packet is delayed by latency plus a uniform value in [-jitter, +jitter], so packets overtake each other
+	chrono::milliseconds jitter{};
+	// probability of dropping a packet, from 0 to 1
+	float loss = 0.0f;
+};
+
+// Two endpoints in one process connected by a simulated link. The clock is a parameter so a headless test can advance
+// time tick by tick instead of waiting for it; losses and delays come from a seeded engine, so a run is repeatable.
+class LoopbackNetwork {
+public:
+	using clock = std::chrono::steady_clock;
+
+	explicit LoopbackNetwork(const LinkConditions& conditions, std::function<clock::time_point()> now = clock::now,
+													 std::uint32_t seed = 0)
+			: conditions{conditions}, now{std::move(now)}, random{seed} {}
+
+	LoopbackNetwork(const LoopbackNetwork&) = delete;
+	LoopbackNetwork& operator=(const LoopbackNetwork&) = delete;
+
+	// What endpoint 0 sends, endpoint 1 receives and the other way around
+	[[nodiscard]] Transport& endpoint(std::size_t index) noexcept {
+		return endpoints[index];
+	}
+
+private:
+	class Endpoint final : public Transport {
+	public:
+		Endpoint(LoopbackNetwork& network, std::size_t index) noexcept : network{network}, index{index} {}
+
+		void send(std::span<const std::byte> packet) override {
+			network.send(1 - index, packet);
+		}
+
+		[[nodiscard]] std::optional<Packet> receive() override {
+			return network.receive(index);
+		}
+
+	private:
+		LoopbackNetwork& network;
+		std::size_t index;
+	};
+
+	void send(std::size_t destination, std::span<const std::byte> packet) {
+		std::scoped_lock lock{mutex};
+		if (std::bernoulli_distribution{conditions.loss}(random))
+			return;
+
+		auto delay = conditions.latency;
+		if (conditions.jitter.count() > 0) {
+			auto jitter = std::uniform_real_distribution<float>{-conditions.jitter.count(), conditions.jitter.count()};
+			delay = std::max(delay + chrono::milliseconds{jitter(random)}, chrono::milliseconds{});
+		}
+
+		const auto arrival = now() + std::chrono::duration_cast<clock::duration>(delay);
+		in_flight[destination].emplace(arrival, Packet{packet.begin(), packet.end()});
+	}
+
+	[[nodiscard]] std::optional<Packet> receive(std::size_t destination) {
+		std::scoped_lock lock{mutex};
+		auto& packets = in_flight[destination];
+		if (packets.empty() or packets.begin()->first > now())
+			return std::nullopt;
+
+		return std::move(packets.extract(packets.begin()).mapped());
+	}
+
+	LinkConditions conditions;
+	std::function<clock::time_point()> now;
+
+	std::mutex mutex;
+	std::mt19937 random;
+	// by arrival time, per destination endpoint
+	std::array<std::multimap<clock::time_point, Packet>, 2> in_flight;
+	std::array<Endpoint, 2> endpoints{Endpoint{*this, 0}, Endpoint{*this, 1}};
+};
+
+// What RollbackSession needs from a simulation: a trivially copyable input per player and tick, a state it can save
+// and load back, a checksum of a saved state, and a fixed step taking the input of both players. Loading a state and
+// ticking must give the same result, bit for bit, as when the state was saved.
+template <typename Game>
+concept RollbackGame =
+		std::is_trivially_copyable_v<typename Game::Input> and std::equality_comparable<typename Game::Input> and
+		std::default_initializable<typename Game::Input> and std::default_initializable<typename Game::State> and
+		requires(Game& game, const Game& const_game, typename Game::State& state, const typename Game::Input& input) {
+			const_game.save(state);
+			game.load(std::as_const(state));
+			{ const_game.checksum(std::as_const(state)) } -> std::convertible_to<std::uint64_t>;
+			game.tick(input, input);
+		};
+
+// GGPO style rollback between two peers that start from the same state. The local input is applied at once and the
+// remote one is predicted to repeat the last one received. When the real remote input of a tick already simulated
+// differs from its prediction, the game is loaded back to the state saved before that tick and simulated again up to
+// the current one.
+//
+// Every packet repeats the local inputs the peer did not acknowledge yet, so a lost packet is made up by the next one.
+// A packet holds, as varints, the number of remote ticks received in a row (the acknowledgement), one past the last
+// tick whose state is final (zero for none) and the checksum of that state, the tick of the first input and the input
+// count, then the inputs as raw bytes. The peer compares the checksum with its own for the tick, a desync shows up a
+// few ticks after it happens instead of at the end of the match.
+template <RollbackGame Game>
+class RollbackSession {
+public:
+	using Input = typename Game::Input;
+	using State = typename Game::State;
+
+	struct Stats {
+		std::uint64_t ticks = 0;
+		std::uint64_t resimulated_ticks = 0;
+		std::uint64_t rollbacks = 0;
+		std::uint64_t max_rollback = 0;
+		// advance() calls that did not tick because the peer was too far behind
+		std::uint64_t stalls = 0;
+		// checksums of the peer compared with the local ones, and how many of them differed
+		std::uint64_t checked_ticks = 0;
+		std::uint64_t desyncs = 0;
+		std::optional<std::uint64_t> first_desync_tick;
+		// time spent in Game::tick(), first runs and resimulations
+		chrono::milliseconds simulation_time{};
+
+		[[nodiscard]] chrono::milliseconds average_tick() const noexcept {
+			const auto count = ticks + resimulated_ticks;
+			return count == 0 ? chrono::milliseconds{} : simulation_time / static_cast<float>(count);
+		}
+
+		// The key figure of a rollback game: how many ticks could be simulated again within one frame
+		[[nodiscard]] float resimulation_capacity(chrono::milliseconds frame_budget) const noexcept {
+			const auto tick = average_tick();
+			return tick.count() > 0.0f ? frame_budget / tick : 0.0f;
+		}
+	};
+
+	// Prediction goes at most max_prediction ticks past the last remote input received, then the session stalls
+	RollbackSession(Game& game, Transport& transport, std::size_t max_prediction = 8)
+			: game{game}, transport{transport}, max_prediction{max_prediction}, frames(2 * max_prediction + 1) {}
+
+	RollbackSession(const RollbackSession&) = delete;
+	RollbackSession& operator=(const RollbackSession&) = delete;
+
+	// Simulates the next tick with the local input, after rolling back if the packets received contradict a
+	// prediction. Returns false, and does not tick, when the peer is too far behind.
+	bool advance(const Input& local) {
+		catch_up();
+		if (current_tick - confirmed_ticks >= max_prediction) {
+			++stats.stalls;
+			send();
+			return false;
+		}
+
+		auto& frame = frame_at(current_tick);
+		if (frame.tick != current_tick)
+			reuse(frame, current_tick);
+		frame.local = local;
+		if (not frame.remote_known)
+			frame.remote = prediction();
+
+		save(frame);
+		timed_tick(frame);
+		++stats.ticks;
+
+		++current_tick;
+		unacknowledged.push_back(local);
+		send();
+		return true;
+	}
+
+	// Receives, rolls back if needed and sends without ticking, so a peer that stopped simulating still lets the other
+	// one confirm its last ticks
+	void idle() {
+		catch_up();
+		send();
+	}
+
+	[[nodiscard]] std::uint64_t tick() const noexcept {
+		return current_tick;
+	}
+
+	// Ticks up to which the remote input is known, the game is final before this one
+	[[nodiscard]] std::uint64_t confirmed_tick() const noexcept {
+		return confirmed_ticks;
+	}
+
+	[[nodiscard]] const Stats& statistics() const noexcept {
+		return stats;
+	}
+
+private:
+	struct Frame {
+		std::uint64_t tick = std::numeric_limits<std::uint64_t>::max();
+		Input local{};
+		Input remote{};
+		bool remote_known = false;
+		// before the tick is simulated
+		State state{};
+		std::uint64_t checksum = 0;
+	};
+
+	[[nodiscard]] Frame& frame_at(std::uint64_t tick) noexcept {
+		return frames[tick % frames.size()];
+	}
+
+	// Keeps the saved state, its buffers are overwritten in place by the next save
+	static void reuse(Frame& frame, std::uint64_t tick) noexcept {
+		frame.tick = tick;
+		frame.remote_known = false;
+	}
+
+	void save(Frame& frame) {
+		game.save(frame.state);
+		frame.checksum = game.checksum(std::as_const(frame.state));
+	}
+
+	// The state before a tick is final once the remote input of every tick before it is known and no rollback is due
+	[[nodiscard]] bool is_final(std::uint64_t tick) const noexcept {
+		return tick <= confirmed_ticks and tick < current_tick and tick <= rollback_tick and
+					 frames[tick % frames.size()].tick == tick;
+	}
+
+	[[nodiscard]] Input prediction() noexcept {
+		return confirmed_ticks == 0 ? Input{} : frame_at(confirmed_ticks - 1).remote;
+	}
+
+	void timed_tick(const Frame& frame) {
+		const auto start = std::chrono::steady_clock::now();
+		game.tick(frame.local, frame.remote);
+		stats.simulation_time += std::chrono::steady_clock::now() - start;
+	}
+
+	void catch_up() {
+		poll();
+		if (rollback_tick < current_tick)
+			resimulate();
+		rollback_tick = std::numeric_limits<std::uint64_t>::max();
+	}
+
+	void resimulate() {
+		const auto depth = current_tick - rollback_tick;
+		++stats.rollbacks;
+		stats.resimulated_ticks += depth;
+		stats.max_rollback = std::max(stats.max_rollback, depth);
+
+		game.load(frame_at(rollback_tick).state);
+		for (auto tick = rollback_tick; tick != current_tick; ++tick) {
+			auto& frame = frame_at(tick);
+			if (tick != rollback_tick)
+				save(frame);
+			if (not frame.remote_known)
+				frame.remote = prediction();
+			timed_tick(frame);
+		}
+	}
+
+	void poll() {
+		while (auto packet = transport.receive()) {
+			try {
+				read(*packet);
+			} catch (const std::runtime_error&) {
+				// a malformed datagram is dropped like a lost one
+			}
+		}
+	}
+
+	void read(std::span<const std::byte> packet) {
+		const auto acknowledged = replay::read_varint(packet);
+		const auto checked = replay::read_varint(packet);
+		const auto checksum = replay::read_varint(packet);
+		const auto first = replay::read_varint(packet);
+		const auto count = replay::read_varint(packet);
+		// count comes from the wire, compared by dividing so a forged one cannot wrap around
+		if (packet.size() % sizeof(Input) != 0 or count != packet.size() / sizeof(Input))
+			return;
+
+		for (auto index = 0uz; index != count; ++index) {
+			Input input;
+			std::memcpy(&input, packet.data() + index * sizeof(Input), sizeof(Input));
+			receive_remote(first + index, input);
+		}
+
+		while (acknowledged_ticks < acknowledged and not unacknowledged.empty()) {
+			unacknowledged.pop_front();
+			++acknowledged_ticks;
+		}
+
+		// a checksum of a state not final here yet is skipped, the next packets carry later ones
+		if (checked != 0 and is_final(checked - 1)) {
+			++stats.checked_ticks;
+			if (frame_at(checked - 1).checksum != checksum) {
+				++stats.desyncs;
+				stats.first_desync_tick = std::min(stats.first_desync_tick.value_or(checked - 1), checked - 1);
+			}
+		}
+	}
+
+	void receive_remote(std::uint64_t tick, const Input& input) {
+		// already known, or further than any peer following the protocol can be
+		if (tick < confirmed_ticks or tick >= confirmed_ticks + frames.size())
+			return;
+
+		auto& frame = frame_at(tick);
+		if (frame.tick != tick)
+			reuse(frame, tick);
+		if (frame.remote_known)
+			return;
+
+		if (tick < current_tick and frame.remote != input)
+			rollback_tick = std::min(rollback_tick, tick);
+		frame.remote = input;
+		frame.remote_known = true;
+
+		while (frame_at(confirmed_ticks).tick == confirmed_ticks and frame_at(confirmed_ticks).remote_known)
+			++confirmed_ticks;
+	}
+
+	void send() {
+		send_buffer.clear();
+		replay::write_varint(send_buffer, confirmed_ticks);
+		// the state before the first tick still waiting for the remote input, or before the last one simulated
+		const auto checked = current_tick == 0 ? 0 : std::min(confirmed_ticks, current_tick - 1) + 1;
+		const auto is_checked = checked != 0 and is_final(checked - 1);
+		replay::write_varint(send_buffer, is_checked ? checked : 0);
+		replay::write_varint(send_buffer, is_checked ? frame_at(checked - 1).checksum : 0);
+		replay::write_varint(send_buffer, acknowledged_ticks);
+		replay::write_varint(send_buffer, unacknowledged.size());
+		for (const auto& input : unacknowledged) {
+			const auto bytes = std::as_bytes(std::span{&input, 1});
+			send_buffer.insert(send_buffer.end(), bytes.begin(), bytes.end());
+		}
+		transport.send(send_buffer);
+	}
+
+	Game& game;
+	Transport& transport;
+	std::size_t max_prediction;
+
+	// ring indexed by tick, it spans the oldest tick a rollback can reach up to the newest remote input accepted
+	std::vector<Frame> frames;
+	std::uint64_t current_tick = 0;
+	std::uint64_t confirmed_ticks = 0;
+	std::uint64_t rollback_tick = std::numeric_limits<std::uint64_t>::max();
+
+	// local inputs from acknowledged_ticks on, sent again until the peer acknowledges them
+	std::deque<Input> unacknowledged;
+	std::uint64_t acknowledged_ticks = 0;
+	Packet send_buffer;
+
+	Stats stats;
+};
+
+} // namespace vis::net
@@ -8,10 +8,22 @@ import std;
 import vis.math;
 import vis.chrono;
 import vis.ecs;
+import vis.jobs;
+import vis.memory;
 
 // non exported
 namespace vis::physics {
 
+#ifdef VIS_TRACK_ALLOCATIONS
+void* box2d_allocate(unsigned int size, int alignment) {
+	return memory::tracked_allocate(size, static_cast<std::size_t>(alignment), memory::AllocationTag::physics);
+}
+
+void box2d_free(void* pointer) {
+	memory::tracked_free(pointer);
+}
+#endif
+
 b2Vec2 to_box2d(vec2 v) {
 	return {v.x, v.y};
 }
@@ -20,6 +32,16 @@ vec2 from_box2d(b2Vec2 v) {
 	return {v.x, v.y};
 }
 
+// The shapes of a RigidBody carry its entity as their user data, a query hit gets it without going through the body
+void* to_user_data(ecs::entity entity) {
+	return reinterpret_cast<void*>(static_cast<std::uintptr_t>(ecs::to_integral(entity)));
+}
+
+ecs::entity shape_entity(b2ShapeId shape) {
+	const auto value = reinterpret_cast<std::uintptr_t>(b2Shape_GetUserData(shape));
+	return static_cast<ecs::entity>(static_cast<ecs::id_type>(value));
+}
+
 } // namespace vis::physics
 
 export namespace vis::physics {
@@ -38,6 +60,10 @@ struct Transform {
 	vec2 position{};
 	Rotation rotation{};
 	vec2 scale{1.0f, 1.0f};
+
+	[[nodiscard]] Affine2D to_affine() const noexcept {
+		return Affine2D::from_trs(position, vec2{rotation.cos_angle, rotation.sin_angle}, scale);
+	}
 };
 
 class SensorBeginTouchEvent {
@@ -76,8 +102,8 @@ private:
 
 class SensorEvent {
 public:
-	using SensorBeginTouchVector = std::vector<SensorBeginTouchEvent>;
-	using SensorEndTouchVector = std::vector<SensorEndTouchEvent>;
+	using SensorBeginTouchVector = std::pmr::vector<SensorBeginTouchEvent>;
+	using SensorEndTouchVector = std::pmr::vector<SensorEndTouchEvent>;
 
 	using SensorBeginTouchVectorValueType = SensorBeginTouchVector::value_type;
 	using SensorBeginTouchVectorIterator = SensorBeginTouchVector::iterator;
@@ -104,7 +130,7 @@ public:
 
 private:
 	friend class World;
-	explicit SensorEvent(const World& world);
+	explicit SensorEvent(const World& world, std::pmr::memory_resource* resource);
 
 	SensorBeginTouchVector begin_touch_events;
 	SensorEndTouchVector end_touch_events;
@@ -146,8 +172,8 @@ private:
 
 class ContactEvent {
 public:
-	using ContactBeginTouchVector = std::vector<ContactBeginTouchEvent>;
-	using ContactEndTouchVector = std::vector<ContactEndTouchEvent>;
+	using ContactBeginTouchVector = std::pmr::vector<ContactBeginTouchEvent>;
+	using ContactEndTouchVector = std::pmr::vector<ContactEndTouchEvent>;
 
 	using ContactBeginTouchVectorConstIterator = ContactBeginTouchVector::const_iterator;
 	using ContactEndTouchVectorConstIterator = ContactEndTouchVector::const_iterator;
@@ -170,7 +196,7 @@ public:
 
 private:
 	friend class World;
-	explicit ContactEvent(const World& world);
+	explicit ContactEvent(const World& world, std::pmr::memory_resource* resource);
 
 	ContactBeginTouchVector begin_touch_events;
 	ContactEndTouchVector end_touch_events;
@@ -199,7 +225,7 @@ private:
 
 class ContactHitEvents {
 public:
-	using ContactHitEventVector = std::vector<ContactHitEvent>;
+	using ContactHitEventVector = std::pmr::vector<ContactHitEvent>;
 
 	using value_type = ContactHitEventVector::value_type;
 	using iterator = ContactHitEventVector::iterator;
@@ -215,7 +241,7 @@ public:
 
 private:
 	friend class World;
-	explicit ContactHitEvents(const World& world);
+	explicit ContactHitEvents(const World& world, std::pmr::memory_resource* resource);
 
 private:
 	ContactHitEventVector events;
@@ -320,16 +346,8 @@ public:
 		}
 	}
 
-	[[nodiscard]] mat4 get_model() const {
-		const auto t = get_transform();
-		auto model = ext::identity<mat4>();
-		model[0][0] = t.rotation.cos_angle;
-		model[1][0] = -t.rotation.sin_angle;
-		model[0][1] = t.rotation.sin_angle;
-		model[1][1] = t.rotation.cos_angle;
-		model[3][0] = t.position.x;
-		model[3][1] = t.position.y;
-		return model;
+	[[nodiscard]] Affine2D get_model() const {
+		return get_transform().to_affine();
 	}
 
 	RigidBody& create_shape(const ShapeDef& shape, const Polygon& polygon);
@@ -584,6 +602,122 @@ struct RayCastResult {
 	vec2 normal;
 };
 
+// Queries of the batched World methods. A cast goes from start to end, the fraction of a hit is the part of the way
+// travelled before touching the shape.
+struct RayQuery {
+	vec2 start;
+	vec2 end;
+};
+
+struct CircleCastQuery {
+	vec2 start;
+	vec2 end;
+	float radius;
+};
+
+// An axis aligned box whose center goes from start to end
+struct BoxCastQuery {
+	vec2 start;
+	vec2 end;
+	vec2 half_extent;
+};
+
+struct AabbQuery {
+	vec2 min;
+	vec2 max;
+};
+
+enum class QueryMode {
+	closest, // at most one hit per query, the first shape along the cast
+	all,     // every shape along the cast, sorted by fraction
+};
+
+// Overlaps only fill the entity, point and normal stay zero
+struct QueryHit {
+	ecs::entity entity;
+	vec2 point{};
+	vec2 normal{};
+	float fraction = 0.0f;
+};
+
+// Output of a batch of queries: results[i] are the hits of the i-th query. Keep one around and pass it to every batch,
+// the buffers keep their capacity, so a batch stops allocating once they have grown to the busiest tick.
+class QueryResults {
+public:
+	[[nodiscard]] std::size_t size() const noexcept {
+		return ranges.size();
+	}
+
+	[[nodiscard]] std::span<const QueryHit> operator[](std::size_t query) const noexcept {
+		const auto [first, count] = ranges[query];
+		return std::span{hits}.subspan(first, count);
+	}
+
+	// every hit of the batch, query after query
+	[[nodiscard]] std::span<const QueryHit> all_hits() const noexcept {
+		return hits;
+	}
+
+	void clear() noexcept {
+		ranges.clear();
+		hits.clear();
+	}
+
+private:
+	friend class World;
+
+	struct Range {
+		std::size_t first;
+		std::size_t count;
+	};
+
+	std::vector<Range> ranges;
+	std::vector<QueryHit> hits;
+	// hits of each chunk of queries before they are merged into hits, one buffer per chunk so the chunks can be
+	// recorded by different threads
+	std::vector<std::vector<QueryHit>> chunks;
+};
+
+// Dynamic state of one body, what a rewind puts back. Shapes, joints and body definitions are not part of it.
+struct BodyState {
+	ecs::entity entity;
+	vec2 position{};
+	Rotation rotation{1.0f, 0.0f};
+	vec2 linear_velocity{};
+	float angular_velocity = 0.0f;
+	bool awake = true;
+	bool enabled = true;
+};
+
+// Flat copy of the bodies of a world, filled by World::snapshot() and put back by World::restore(). Keep one around
+// and capture into it again: the buffers keep their capacity, so rewind loops stop allocating after the first capture.
+class WorldSnapshot {
+public:
+	[[nodiscard]] std::span<const BodyState> bodies() const noexcept {
+		return states;
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return states.size();
+	}
+
+	[[nodiscard]] bool empty() const noexcept {
+		return states.empty();
+	}
+
+	void clear() noexcept {
+		states.clear();
+		body_ids.clear();
+	}
+
+private:
+	friend class World;
+
+	std::vector<BodyState> states;
+	// parallel to states, restore() writes through them without looking the entities up
+	std::vector<b2BodyId> body_ids;
+};
+
 class World {
 public:
 	World() : id{b2_nullWorldId} {}
@@ -614,6 +748,7 @@ public:
 	}
 
 	void step(chrono::seconds time_step, int sub_step_count) const {
+		memory::AllocationScope allocation_scope{memory::AllocationTag::physics};
 		b2World_Step(id, time_step.count(), sub_step_count);
 	}
 
@@ -623,16 +758,68 @@ public:
 
 	[[nodiscard]] std::optional<RayCastResult> cast_ray(vec2 start, vec2 end) const;
 
-	[[nodiscard]] ContactHitEvents get_hit_events() const {
-		return ContactHitEvents{*this};
+	// Batched queries, the results of the previous batch in results are replaced. With a pool the queries are split in
+	// chunks recorded by its workers, the world must not be stepped or changed meanwhile.
+	void cast_rays(std::span<const RayQuery> rays, QueryMode mode, QueryResults& results,
+								 jobs::ThreadPool* pool = nullptr) const;
+	void cast_circles(std::span<const CircleCastQuery> casts, QueryMode mode, QueryResults& results,
+										jobs::ThreadPool* pool = nullptr) const;
+	void cast_boxes(std::span<const BoxCastQuery> casts, QueryMode mode, QueryResults& results,
+									jobs::ThreadPool* pool = nullptr) const;
+	// every shape whose bounding box overlaps the box
+	void overlap_aabbs(std::span<const AabbQuery> boxes, QueryResults& results, jobs::ThreadPool* pool = nullptr) const;
+
+	// Captures every RigidBody of the registry. The world must own all of them.
+	void snapshot(const ecs::registry& registry, WorldSnapshot& snapshot) const {
+		snapshot.clear();
+		for (auto [entity, body] : registry.view<RigidBody>().each()) {
+			const auto body_id = body.id;
+			const auto [p, q] = b2Body_GetTransform(body_id);
+			snapshot.states.push_back(BodyState{
+					.entity = entity,
+					.position = from_box2d(p),
+					.rotation = {q.c, q.s},
+					.linear_velocity = from_box2d(b2Body_GetLinearVelocity(body_id)),
+					.angular_velocity = b2Body_GetAngularVelocity(body_id),
+					.awake = b2Body_IsAwake(body_id),
+					.enabled = b2Body_IsEnabled(body_id),
+			});
+			snapshot.body_ids.push_back(body_id);
+		}
+	}
+
+	// Puts the captured bodies back. Bodies destroyed since the capture are skipped and bodies created since are left
+	// alone. Contacts, their warm starting and the sensor overlaps are not part of the snapshot: the ones of the world
+	// stay, so a resimulation matches the original run closely but not bit for bit. For that, restore into a world
+	// built again from scratch, where there are none.
+	void restore(const WorldSnapshot& snapshot) const {
+		for (auto index = 0uz; index != snapshot.states.size(); ++index)
+			if (b2Body_IsValid(snapshot.body_ids[index]))
+				restore(snapshot.body_ids[index], snapshot.states[index]);
+	}
+
+	// Same, finding the bodies through the entities of the capture, for a world whose bodies were created again since
+	void restore(const ecs::registry& registry, const WorldSnapshot& snapshot) const {
+		for (const auto& state : snapshot.states)
+			if (const auto* body = registry.try_get<RigidBody>(state.entity); body != nullptr and b2Body_IsValid(body->id))
+				restore(body->id, state);
+	}
+
+	// The events of the last step are copied into vectors of the given resource, a per-frame one keeps the steps off the
+	// general heap
+	[[nodiscard]] ContactHitEvents
+	get_hit_events(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const {
+		return ContactHitEvents{*this, resource};
 	}
 
-	[[nodiscard]] SensorEvent get_sensor_events() const {
-		return SensorEvent{*this};
+	[[nodiscard]] SensorEvent
+	get_sensor_events(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const {
+		return SensorEvent{*this, resource};
 	}
 
-	[[nodiscard]] ContactEvent get_contact_events() const {
-		return ContactEvent{*this};
+	[[nodiscard]] ContactEvent
+	get_contact_events(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const {
+		return ContactEvent{*this, resource};
 	}
 
 	explicit operator b2WorldId() const {
@@ -642,11 +829,83 @@ public:
 private:
 	explicit World(const WorldDef& world_def) : id{b2CreateWorld(static_cast<const b2WorldDef*>(world_def))} {}
 
+	struct CastContext {
+		std::vector<QueryHit>& hits;
+		std::size_t first;
+		QueryMode mode;
+	};
+
+	static void restore(b2BodyId body_id, const BodyState& state) {
+		if (state.enabled and not b2Body_IsEnabled(body_id))
+			b2Body_Enable(body_id);
+		else if (not state.enabled and b2Body_IsEnabled(body_id))
+			b2Body_Disable(body_id);
+
+		b2Body_SetTransform(body_id, to_box2d(state.position), b2Rot{state.rotation.cos_angle, state.rotation.sin_angle});
+		b2Body_SetLinearVelocity(body_id, to_box2d(state.linear_velocity));
+		b2Body_SetAngularVelocity(body_id, state.angular_velocity);
+		// last, setting a velocity wakes the body up
+		b2Body_SetAwake(body_id, state.awake);
+	}
+
+	static float record_cast(b2ShapeId shape, b2Vec2 point, b2Vec2 normal, float fraction, void* context);
+	static bool record_overlap(b2ShapeId shape, void* context);
+
+	// Runs query(queries[i], hits) for every query, appending its hits. Chunks of queries record into buffers of their
+	// own, on the workers of the pool if any, and are merged in query order at the end.
+	template <typename Query, typename Fn>
+	void run_queries(std::span<const Query> queries, QueryResults& results, jobs::ThreadPool* pool, Fn query) const {
+		constexpr std::size_t chunk_size = 64;
+		const auto chunk_count = (queries.size() + chunk_size - 1) / chunk_size;
+		results.ranges.resize(queries.size());
+		if (results.chunks.size() < chunk_count)
+			results.chunks.resize(chunk_count);
+
+		auto record_chunk = [&](std::size_t chunk) {
+			auto& hits = results.chunks[chunk];
+			hits.clear();
+			const auto last = std::min(queries.size(), (chunk + 1) * chunk_size);
+			for (auto index = chunk * chunk_size; index != last; ++index) {
+				const auto first = hits.size();
+				query(queries[index], hits);
+				results.ranges[index] = {first, hits.size() - first};
+			}
+		};
+
+		if (pool != nullptr and chunk_count > 1)
+			pool->parallel_for(chunk_count, record_chunk);
+		else
+			for (auto chunk = 0uz; chunk != chunk_count; ++chunk)
+				record_chunk(chunk);
+
+		results.hits.clear();
+		for (auto chunk = 0uz; chunk != chunk_count; ++chunk) {
+			const auto offset = results.hits.size();
+			const auto last = std::min(queries.size(), (chunk + 1) * chunk_size);
+			for (auto index = chunk * chunk_size; index != last; ++index)
+				results.ranges[index].first += offset;
+			results.hits.insert(results.hits.end(), results.chunks[chunk].begin(), results.chunks[chunk].end());
+		}
+	}
+
+	// Records the hits of one cast into hits, cast(context) runs the box2d query with record_cast
+	template <typename Fn> static void record_casts(std::vector<QueryHit>& hits, QueryMode mode, Fn cast) {
+		auto context = CastContext{.hits = hits, .first = hits.size(), .mode = mode};
+		cast(context);
+		if (mode == QueryMode::all)
+			std::ranges::sort(hits.begin() + static_cast<std::ptrdiff_t>(context.first), hits.end(), {},
+												&QueryHit::fraction);
+	}
+
 private:
 	b2WorldId id;
 };
 
 World create_world(const WorldDef& world_def) {
+#ifdef VIS_TRACK_ALLOCATIONS
+	// before anything is allocated, Box2D frees with the function it allocated with
+	[[maybe_unused]] static const bool box2d_tracked = (b2SetAllocator(box2d_allocate, box2d_free), true);
+#endif
 	return World{world_def};
 }
 
@@ -656,7 +915,8 @@ RigidBody::RigidBody(const World& world, const RigidBodyDef& def, ecs::entity en
 	b2Body_SetUserData(id, &user_data);
 }
 
-SensorEvent::SensorEvent(const World& world) {
+SensorEvent::SensorEvent(const World& world, std::pmr::memory_resource* resource)
+		: begin_touch_events{resource}, end_touch_events{resource} {
 	auto [beginEvents, endEvents, beginCount, endCount] = b2World_GetSensorEvents(static_cast<b2WorldId>(world));
 
 	begin_touch_events.resize(static_cast<std::size_t>(beginCount));
@@ -671,7 +931,8 @@ SensorEvent::SensorEvent(const World& world) {
 								 [](const auto& e) { return SensorEndTouchEvent{e}; });
 }
 
-ContactEvent::ContactEvent(const World& world) {
+ContactEvent::ContactEvent(const World& world, std::pmr::memory_resource* resource)
+		: begin_touch_events{resource}, end_touch_events{resource} {
 	auto [beginEvents, endEvents, hitEvents, beginCount, endCount, hitCount] =
 			b2World_GetContactEvents(static_cast<b2WorldId>(world));
 
@@ -687,7 +948,7 @@ ContactEvent::ContactEvent(const World& world) {
 								 [](const auto& e) { return ContactEndTouchEvent{e}; });
 }
 
-ContactHitEvents::ContactHitEvents(const World& world) {
+ContactHitEvents::ContactHitEvents(const World& world, std::pmr::memory_resource* resource) : events{resource} {
 	auto contacts = b2World_GetContactEvents(static_cast<b2WorldId>(world));
 
 	events.resize(static_cast<std::size_t>(contacts.hitCount));
@@ -714,9 +975,7 @@ private:
 
 class ShapeDef {
 public:
-	ShapeDef() : def{b2DefaultShapeDef()} {
-		def.userData = this;
-	}
+	ShapeDef() : def{b2DefaultShapeDef()} {}
 
 	ShapeDef& set_restitution(float restitution) {
 		def.restitution = restitution;
@@ -766,12 +1025,16 @@ struct Circle {
 };
 
 RigidBody& RigidBody::create_shape(const ShapeDef& shape, const Polygon& polygon) {
-	b2CreatePolygonShape(id, static_cast<const b2ShapeDef*>(shape), static_cast<const b2Polygon*>(polygon));
+	auto def = *static_cast<const b2ShapeDef*>(shape);
+	def.userData = to_user_data(user_data.entity);
+	b2CreatePolygonShape(id, &def, static_cast<const b2Polygon*>(polygon));
 	return *this;
 }
 
 RigidBody& RigidBody::create_shape(const ShapeDef& shape, const Circle& circle) {
-	b2CreateCircleShape(id, static_cast<const b2ShapeDef*>(shape), static_cast<const b2Circle*>(circle));
+	auto def = *static_cast<const b2ShapeDef*>(shape);
+	def.userData = to_user_data(user_data.entity);
+	b2CreateCircleShape(id, &def, static_cast<const b2Circle*>(circle));
 	return *this;
 }
 
@@ -782,7 +1045,7 @@ std::optional<RayCastResult> World::cast_ray(vec2 start, vec2 end) const {
 		return std::nullopt;
 
 	auto bodyId = b2Shape_GetBody(res.shapeId);
-	auto body = static_cast<RigidBody*>(b2Body_GetUserData(bodyId))->user_data.self;
+	auto body = static_cast<RigidBody::InternalUserData*>(b2Body_GetUserData(bodyId))->self;
 
 	return RayCastResult{
 			.body = std::ref(*body),
@@ -791,4 +1054,128 @@ std::optional<RayCastResult> World::cast_ray(vec2 start, vec2 end) const {
 	};
 }
 
+float World::record_cast(b2ShapeId shape, b2Vec2 point, b2Vec2 normal, float fraction, void* context) {
+	auto& cast = *static_cast<CastContext*>(context);
+	const auto hit = QueryHit{
+			.entity = shape_entity(shape),
+			.point = from_box2d(point),
+			.normal = from_box2d(normal),
+			.fraction = fraction,
+	};
+
+	if (cast.mode == QueryMode::all) {
+		cast.hits.push_back(hit);
+		return 1.0f;
+	}
+
+	if (cast.hits.size() == cast.first)
+		cast.hits.push_back(hit);
+	else
+		cast.hits.back() = hit;
+	// clips the cast, box2d only reports closer shapes from now on
+	return fraction;
+}
+
+bool World::record_overlap(b2ShapeId shape, void* context) {
+	static_cast<std::vector<QueryHit>*>(context)->push_back(QueryHit{.entity = shape_entity(shape)});
+	return true;
+}
+
+void World::cast_rays(std::span<const RayQuery> rays, QueryMode mode, QueryResults& results,
+											jobs::ThreadPool* pool) const {
+	run_queries(rays, results, pool, [this, mode](const RayQuery& ray, std::vector<QueryHit>& hits) {
+		record_casts(hits, mode, [&](CastContext& context) {
+			b2World_CastRay(id, to_box2d(ray.start), to_box2d(ray.end - ray.start), b2DefaultQueryFilter(), record_cast,
+											&context);
+		});
+	});
+}
+
+void World::cast_circles(std::span<const CircleCastQuery> casts, QueryMode mode, QueryResults& results,
+												 jobs::ThreadPool* pool) const {
+	run_queries(casts, results, pool, [this, mode](const CircleCastQuery& cast, std::vector<QueryHit>& hits) {
+		const auto circle = b2Circle{.center = b2Vec2_zero, .radius = cast.radius};
+		const auto origin = b2Transform{.p = to_box2d(cast.start), .q = b2Rot_identity};
+		record_casts(hits, mode, [&](CastContext& context) {
+			b2World_CastCircle(id, &circle, origin, to_box2d(cast.end - cast.start), b2DefaultQueryFilter(), record_cast,
+												 &context);
+		});
+	});
+}
+
+void World::cast_boxes(std::span<const BoxCastQuery> casts, QueryMode mode, QueryResults& results,
+											 jobs::ThreadPool* pool) const {
+	run_queries(casts, results, pool, [this, mode](const BoxCastQuery& cast, std::vector<QueryHit>& hits) {
+		const auto box = b2MakeBox(cast.half_extent.x, cast.half_extent.y);
+		const auto origin = b2Transform{.p = to_box2d(cast.start), .q = b2Rot_identity};
+		record_casts(hits, mode, [&](CastContext& context) {
+			b2World_CastPolygon(id, &box, origin, to_box2d(cast.end - cast.start), b2DefaultQueryFilter(), record_cast,
+													&context);
+		});
+	});
+}
+
+void World::overlap_aabbs(std::span<const AabbQuery> boxes, QueryResults& results, jobs::ThreadPool* pool) const {
+	run_queries(boxes, results, pool, [this](const AabbQuery& box, std::vector<QueryHit>& hits) {
+		const auto aabb = b2AABB{.lowerBound = to_box2d(box.min), .upperBound = to_box2d(box.max)};
+		b2World_OverlapAABB(id, aabb, b2DefaultQueryFilter(), record_overlap, &hits);
+	});
+}
+
+struct SnapshotBenchmark {
+	std::size_t body_count;
+	chrono::microseconds snapshot;
+	chrono::microseconds restore;
+};
+
+// Average cost of World::snapshot() and World::restore() for each body count. Every run builds its own world of
+// dynamic boxes stacked on a grid and steps it once, so the bodies have velocities and contacts when captured.
+std::vector<SnapshotBenchmark> benchmark_snapshot(std::span<const std::size_t> body_counts, int repetitions = 100) {
+	constexpr std::size_t columns = 100;
+	if (repetitions <= 0)
+		throw std::invalid_argument{std::format("Cannot average over {} repetitions", repetitions)};
+
+	std::vector<SnapshotBenchmark> results;
+	results.reserve(body_counts.size());
+	for (const auto body_count : body_counts) {
+		auto world_def = WorldDef{};
+		world_def.set_gravity(vec2{0.0f, -10.0f});
+		auto world = create_world(world_def);
+		// after the world, the bodies are destroyed first
+		ecs::registry registry;
+
+		const auto box = create_box2d(vec2{0.5f, 0.5f});
+		const auto shape_def = ShapeDef{};
+		for (auto i = 0uz; i != body_count; ++i) {
+			const auto entity = registry.create();
+			const auto position = vec2{static_cast<float>(i % columns), static_cast<float>(i / columns)} * 1.5f;
+			auto body_def = RigidBodyDef{} //
+													.set_body_type(BodyType::dynamic)
+													.set_position(position);
+			registry.emplace<RigidBody>(entity, world.create_body(body_def, entity)).create_shape(shape_def, box);
+		}
+		world.step(chrono::seconds{1.0f / 60.0f}, 4);
+
+		WorldSnapshot snapshot;
+		// sizes the buffers, the measured captures reuse them
+		world.snapshot(registry, snapshot);
+
+		const auto snapshot_start = std::chrono::steady_clock::now();
+		for (auto i = 0; i != repetitions; ++i)
+			world.snapshot(registry, snapshot);
+		const auto restore_start = std::chrono::steady_clock::now();
+		for (auto i = 0; i != repetitions; ++i)
+			world.restore(snapshot);
+		const auto restore_end = std::chrono::steady_clock::now();
+
+		const auto count = static_cast<float>(repetitions);
+		results.push_back(SnapshotBenchmark{
+				.body_count = body_count,
+				.snapshot = chrono::microseconds{restore_start - snapshot_start} / count,
+				.restore = chrono::microseconds{restore_end - restore_start} / count,
+		});
+	}
+	return results;
+}
+
 } // namespace vis::physics
\ No newline at end of file
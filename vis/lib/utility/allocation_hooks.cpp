@@ -0,0 +1,104 @@
+// Replacements of the global allocation functions counting every heap allocation for the tag of the calling thread, see
+// vis::memory::AllocationScope. Only built with WITH_ALLOCATION_TRACKING.
+
+import std;
+import vis.memory;
+
+namespace {
+
+void* allocate(std::size_t bytes, std::size_t alignment) {
+	if (auto* pointer = vis::memory::tracked_allocate(bytes, alignment, vis::memory::current_allocation_tag()))
+		return pointer;
+
+	throw std::bad_alloc{};
+}
+
+void* allocate(std::size_t bytes, std::size_t alignment, const std::nothrow_t&) noexcept {
+	return vis::memory::tracked_allocate(bytes, alignment, vis::memory::current_allocation_tag());
+}
+
+constexpr auto default_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+} // namespace
+
+void* operator new(std::size_t bytes) {
+	return allocate(bytes, default_alignment);
+}
+
+void* operator new[](std::size_t bytes) {
+	return allocate(bytes, default_alignment);
+}
+
+void* operator new(std::size_t bytes, std::align_val_t alignment) {
+	return allocate(bytes, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t bytes, std::align_val_t alignment) {
+	return allocate(bytes, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t bytes, const std::nothrow_t& tag) noexcept {
+	return allocate(bytes, default_alignment, tag);
+}
+
+void* operator new[](std::size_t bytes, const std::nothrow_t& tag) noexcept {
+	return allocate(bytes, default_alignment, tag);
+}
+
+void* operator new(std::size_t bytes, std::align_val_t alignment, const std::nothrow_t& tag) noexcept {
+	return allocate(bytes, static_cast<std::size_t>(alignment), tag);
+}
+
+void* operator new[](std::size_t bytes, std::align_val_t alignment, const std::nothrow_t& tag) noexcept {
+	return allocate(bytes, static_cast<std::size_t>(alignment), tag);
+}
+
+// the header of the block knows its size and alignment, every delete ends up in the same place
+
+void operator delete(void* pointer) noexcept {
+	vis::memory::tracked_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	vis::memory::tracked_free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+	vis::memory::tracked_free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+	vis::memory::tracked_free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+	vis::memory::tracked_free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+	vis::memory::tracked_free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+	vis::memory::tracked_free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+	vis::memory::tracked_free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+	vis::memory::tracked_free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+	vis::memory::tracked_free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+	vis::memory::tracked_free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+	vis::memory::tracked_free(pointer);
+}
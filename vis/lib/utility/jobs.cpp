@@ -0,0 +1,248 @@
+module;
+
+export module vis.jobs;
+
+import std;
+
+export namespace vis::jobs {
+
+// A fixed set of worker threads fed by a single queue. The calling thread always takes part in parallel_for, so a
+// pool with zero workers degrades to a plain loop.
+class ThreadPool {
+public:
+	explicit ThreadPool(std::size_t worker_count = default_worker_count()) {
+		workers.reserve(worker_count);
+		for (auto i = 0uz; i < worker_count; ++i)
+			workers.emplace_back([this](std::stop_token stop_token) { run(stop_token); });
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool() {
+		for (auto& worker : workers)
+			worker.request_stop();
+		tasks_available.notify_all();
+	}
+
+	static std::size_t default_worker_count() noexcept {
+		const auto hardware_threads = std::thread::hardware_concurrency();
+		return hardware_threads > 1 ? hardware_threads - 1 : 0;
+	}
+
+	[[nodiscard]] std::size_t worker_count() const noexcept {
+		return workers.size();
+	}
+
+	// Calls fn(index) for every index in [0, count) and returns when all of them are done. fn must not throw.
+	template <typename Fn> void parallel_for(std::size_t count, Fn&& fn) {
+		if (count == 0)
+			return;
+
+		std::atomic<std::size_t> next_index{0};
+		auto drain = [&] {
+			for (auto index = next_index.fetch_add(1); index < count; index = next_index.fetch_add(1))
+				fn(index);
+		};
+
+		const auto helper_count = std::min(count - 1, workers.size());
+		std::latch helpers_done{static_cast<std::ptrdiff_t>(helper_count)};
+
+		{
+			std::lock_guard lock{mutex};
+			for (auto i = 0uz; i < helper_count; ++i)
+				tasks.emplace_back([&] {
+					drain();
+					helpers_done.count_down();
+				});
+		}
+		tasks_available.notify_all();
+
+		drain();
+		helpers_done.wait();
+	}
+
+	// Runs fn on a worker, its result or exception comes back through the future. Without workers fn runs right away on
+	// the calling thread. fn must not wait for other submitted tasks.
+	template <typename Fn> [[nodiscard]] auto submit(Fn&& fn) -> std::future<std::invoke_result_t<std::decay_t<Fn>&>> {
+		using Result = std::invoke_result_t<std::decay_t<Fn>&>;
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+		auto result = task->get_future();
+
+		if (workers.empty()) {
+			(*task)();
+			return result;
+		}
+
+		{
+			std::lock_guard lock{mutex};
+			tasks.emplace_back([task] { (*task)(); });
+		}
+		tasks_available.notify_one();
+		return result;
+	}
+
+private:
+	void run(std::stop_token stop_token) {
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock lock{mutex};
+				if (not tasks_available.wait(lock, stop_token, [this] { return not tasks.empty(); }))
+					return;
+
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable_any tasks_available;
+	std::deque<std::function<void()>> tasks;
+	std::vector<std::jthread> workers;
+};
+
+// Hands values from one producer thread to one consumer thread without locks. The producer always has a buffer to fill
+// and the consumer always has the latest complete one to read, a value published twice before being read is replaced.
+template <typename T> class TripleBuffer {
+public:
+	TripleBuffer() = default;
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// Producer side: the buffer keeps what was written into it two publications ago, so containers keep their capacity
+	[[nodiscard]] T& write_buffer() noexcept {
+		return buffers[write_index].value;
+	}
+
+	void publish() noexcept {
+		const auto published = static_cast<std::uint8_t>(write_index | fresh_bit);
+		const auto previous = middle.exchange(published, std::memory_order_acq_rel);
+		write_index = static_cast<std::uint8_t>(previous & index_mask);
+	}
+
+	// Consumer side: returns false, and keeps the current read buffer, when nothing was published since the last call
+	bool update() noexcept {
+		if ((middle.load(std::memory_order_relaxed) & fresh_bit) == 0)
+			return false;
+
+		const auto previous = middle.exchange(read_index, std::memory_order_acq_rel);
+		read_index = static_cast<std::uint8_t>(previous & index_mask);
+		return true;
+	}
+
+	// Consumer side: the read buffer belongs to the consumer until the next update(), it may modify it
+	[[nodiscard]] T& read_buffer() noexcept {
+		return buffers[read_index].value;
+	}
+
+	[[nodiscard]] const T& read_buffer() const noexcept {
+		return buffers[read_index].value;
+	}
+
+private:
+	static constexpr std::uint8_t index_mask = 0b011;
+	static constexpr std::uint8_t fresh_bit = 0b100;
+
+	// the two sides write different buffers, keep them on different cache lines
+	struct alignas(64) Slot {
+		T value{};
+	};
+
+	std::array<Slot, 3> buffers;
+	alignas(64) std::atomic<std::uint8_t> middle{1};
+	alignas(64) std::uint8_t write_index = 0;
+	alignas(64) std::uint8_t read_index = 2;
+};
+
+// Bounded queue that any number of producer threads push into and one consumer thread pops from, without locks. Every
+// slot carries a sequence number telling whose turn it is: producers claim a slot with a compare and swap on the tail,
+// the consumer owns the head alone. A full queue refuses a push instead of blocking.
+template <typename T> class MpscQueue {
+public:
+	// The capacity is rounded up to a power of two
+	explicit MpscQueue(std::size_t capacity)
+			: mask{std::bit_ceil(std::max(capacity, 2uz)) - 1}, slots{std::make_unique<Slot[]>(mask + 1)} {
+		for (auto i = 0uz; i <= mask; ++i)
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	~MpscQueue() {
+		// destroys the values never popped
+		consume([](T&&) {}, capacity());
+	}
+
+	// Any thread. Returns false, and drops the value, when the queue is full.
+	bool try_push(T value) {
+		auto tail = tail_position.load(std::memory_order_relaxed);
+		for (;;) {
+			auto& slot = slots[tail & mask];
+			const auto sequence = slot.sequence.load(std::memory_order_acquire);
+			if (sequence == tail) {
+				if (tail_position.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+					::new (slot.storage) T(std::move(value));
+					slot.sequence.store(tail + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (sequence < tail) {
+				// the consumer did not free this slot yet since it was filled one lap ago
+				return false;
+			} else {
+				// another producer claimed the slot first
+				tail = tail_position.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Consumer thread only
+	[[nodiscard]] std::optional<T> try_pop() {
+		auto& slot = slots[head_position & mask];
+		if (slot.sequence.load(std::memory_order_acquire) != head_position + 1)
+			return std::nullopt;
+
+		auto* value = std::launder(reinterpret_cast<T*>(slot.storage));
+		std::optional<T> popped{std::move(*value)};
+		value->~T();
+		// the slot is free for the push of the next lap
+		slot.sequence.store(head_position + mask + 1, std::memory_order_release);
+		++head_position;
+		return popped;
+	}
+
+	// Consumer thread only. Pops at most max_count values into the function, in push order, and returns how many.
+	template <typename Function> std::size_t consume(Function&& function, std::size_t max_count) {
+		auto count = 0uz;
+		for (; count < max_count; ++count) {
+			auto value = try_pop();
+			if (not value)
+				break;
+			std::invoke(function, std::move(*value));
+		}
+		return count;
+	}
+
+	[[nodiscard]] std::size_t capacity() const noexcept {
+		return mask + 1;
+	}
+
+private:
+	struct Slot {
+		std::atomic<std::size_t> sequence;
+		alignas(T) std::byte storage[sizeof(T)];
+	};
+
+	std::size_t mask;
+	std::unique_ptr<Slot[]> slots;
+	// producers and the consumer write different ends, keep them on different cache lines
+	alignas(64) std::atomic<std::size_t> tail_position{0};
+	alignas(64) std::size_t head_position = 0;
+};
+
+} // namespace vis::jobs
@@ -0,0 +1,584 @@
+export module vis.memory;
+
+import std;
+import vis.ecs;
+
+// non exported
+namespace vis::memory {
+
+constexpr std::size_t max_alignment = alignof(std::max_align_t);
+
+constexpr std::size_t round_up(std::size_t value, std::size_t alignment) noexcept {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace vis::memory
+
+export namespace vis::memory {
+
+#ifdef VIS_TRACK_ALLOCATIONS
+constexpr bool allocation_tracking = true;
+#else
+constexpr bool allocation_tracking = false;
+#endif
+
+// The subsystem an allocation is counted for
+enum class AllocationTag : std::uint8_t { general, physics, ecs, gl, vk, game };
+
+constexpr std::size_t allocation_tag_count = 6;
+
+[[nodiscard]] constexpr std::string_view to_string(AllocationTag tag) noexcept {
+	constexpr std::array<std::string_view, allocation_tag_count> names{"general", "physics", "ecs", "gl", "vk", "game"};
+	return names[std::to_underlying(tag)];
+}
+
+} // namespace vis::memory
+
+// non exported
+namespace vis::memory {
+
+struct TagCounters {
+	std::atomic<std::uint64_t> allocations;
+	std::atomic<std::uint64_t> deallocations;
+	std::atomic<std::uint64_t> allocated_bytes;
+	std::atomic<std::uint64_t> freed_bytes;
+};
+
+// Same counts for the calling thread alone, only that thread touches them
+struct ThreadTagCounters {
+	std::uint64_t allocations;
+	std::uint64_t deallocations;
+	std::uint64_t allocated_bytes;
+	std::uint64_t freed_bytes;
+};
+
+constinit std::array<TagCounters, allocation_tag_count> tag_counters{};
+constinit thread_local std::array<ThreadTagCounters, allocation_tag_count> thread_tag_counters{};
+constinit thread_local AllocationTag current_tag = AllocationTag::general;
+
+// Written right before the pointer handed out, so a free without a size, like Box2D's or Vulkan's, still finds out what
+// to count and where the block starts
+struct TrackedHeader {
+	void* block;
+	std::size_t bytes;
+	AllocationTag tag;
+};
+
+} // namespace vis::memory
+
+export namespace vis::memory {
+
+struct AllocationCounters {
+	std::uint64_t allocations = 0;
+	std::uint64_t deallocations = 0;
+	std::uint64_t allocated_bytes = 0;
+	std::uint64_t freed_bytes = 0;
+
+	[[nodiscard]] std::int64_t live_bytes() const noexcept {
+		return static_cast<std::int64_t>(allocated_bytes) - static_cast<std::int64_t>(freed_bytes);
+	}
+
+	AllocationCounters& operator+=(const AllocationCounters& other) noexcept {
+		allocations += other.allocations;
+		deallocations += other.deallocations;
+		allocated_bytes += other.allocated_bytes;
+		freed_bytes += other.freed_bytes;
+		return *this;
+	}
+
+	// What happened between two readings of the counters
+	[[nodiscard]] friend AllocationCounters operator-(const AllocationCounters& after,
+																										const AllocationCounters& before) noexcept {
+		return AllocationCounters{
+				.allocations = after.allocations - before.allocations,
+				.deallocations = after.deallocations - before.deallocations,
+				.allocated_bytes = after.allocated_bytes - before.allocated_bytes,
+				.freed_bytes = after.freed_bytes - before.freed_bytes,
+		};
+	}
+};
+
+struct AllocationStats {
+	std::array<AllocationCounters, allocation_tag_count> tags{};
+
+	[[nodiscard]] const AllocationCounters& operator[](AllocationTag tag) const noexcept {
+		return tags[std::to_underlying(tag)];
+	}
+
+	[[nodiscard]] AllocationCounters total() const noexcept {
+		AllocationCounters sum;
+		for (const auto& counters : tags)
+			sum += counters;
+		return sum;
+	}
+
+	[[nodiscard]] friend AllocationStats operator-(const AllocationStats& after, const AllocationStats& before) noexcept {
+		AllocationStats difference;
+		for (auto i = 0uz; i < allocation_tag_count; ++i)
+			difference.tags[i] = after.tags[i] - before.tags[i];
+		return difference;
+	}
+};
+
+// Counters of every heap allocation made since the start, all zero unless built with WITH_ALLOCATION_TRACKING
+[[nodiscard]] AllocationStats allocation_stats() noexcept {
+	AllocationStats stats;
+	for (auto i = 0uz; i < allocation_tag_count; ++i) {
+		stats.tags[i] = AllocationCounters{
+				.allocations = tag_counters[i].allocations.load(std::memory_order_relaxed),
+				.deallocations = tag_counters[i].deallocations.load(std::memory_order_relaxed),
+				.allocated_bytes = tag_counters[i].allocated_bytes.load(std::memory_order_relaxed),
+				.freed_bytes = tag_counters[i].freed_bytes.load(std::memory_order_relaxed),
+		};
+	}
+	return stats;
+}
+
+// Same as allocation_stats() for the heap calls made by the calling thread only: an allocation counts for the thread
+// that made it and a free for the thread that made the free
+[[nodiscard]] AllocationStats thread_allocation_stats() noexcept {
+	AllocationStats stats;
+	for (auto i = 0uz; i < allocation_tag_count; ++i) {
+		const auto& counters = thread_tag_counters[i];
+		stats.tags[i] = AllocationCounters{
+				.allocations = counters.allocations,
+				.deallocations = counters.deallocations,
+				.allocated_bytes = counters.allocated_bytes,
+				.freed_bytes = counters.freed_bytes,
+		};
+	}
+	return stats;
+}
+
+// "physics: 2 allocations, 96 bytes; game: 1 allocation, 24 bytes", the tags that allocated nothing are left out
+[[nodiscard]] std::string describe_allocations(const AllocationStats& stats) {
+	std::string description;
+	for (auto i = 0uz; i < allocation_tag_count; ++i) {
+		const auto& counters = stats.tags[i];
+		if (counters.allocations == 0)
+			continue;
+
+		std::format_to(std::back_inserter(description), "{}{}: {} allocation{}, {} bytes", description.empty() ? "" : "; ",
+									 to_string(static_cast<AllocationTag>(i)), counters.allocations, counters.allocations == 1 ? "" : "s",
+									 counters.allocated_bytes);
+	}
+	return description;
+}
+
+[[nodiscard]] AllocationTag current_allocation_tag() noexcept {
+	return current_tag;
+}
+
+// Counts the allocations of the calling thread for a tag until it goes out of scope. Scopes nest, the innermost wins.
+class AllocationScope {
+public:
+	explicit AllocationScope(AllocationTag tag) noexcept : previous{std::exchange(current_tag, tag)} {}
+
+	AllocationScope(const AllocationScope&) = delete;
+	AllocationScope& operator=(const AllocationScope&) = delete;
+
+	~AllocationScope() {
+		current_tag = previous;
+	}
+
+private:
+	AllocationTag previous;
+};
+
+// malloc() and free() plus the bookkeeping of the tracker, for the allocation hooks: the global operator new and
+// delete, Box2D's allocator and the Vulkan allocation callbacks. Every block carries its own header, so they are thread
+// safe.
+[[nodiscard]] void* tracked_allocate(std::size_t bytes, std::size_t alignment, AllocationTag tag) noexcept {
+	alignment = std::max(alignment, max_alignment);
+	auto* block = static_cast<std::byte*>(std::malloc(sizeof(TrackedHeader) + alignment + bytes));
+	if (block == nullptr)
+		return nullptr;
+
+	const auto address = reinterpret_cast<std::uintptr_t>(block + sizeof(TrackedHeader));
+	auto* pointer = block + sizeof(TrackedHeader) + (round_up(address, alignment) - address);
+	::new (pointer - sizeof(TrackedHeader)) TrackedHeader{block, bytes, tag};
+
+	auto& counters = tag_counters[std::to_underlying(tag)];
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+	counters.allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+	auto& thread_counters = thread_tag_counters[std::to_underlying(tag)];
+	++thread_counters.allocations;
+	thread_counters.allocated_bytes += bytes;
+	return pointer;
+}
+
+// Size requested for a block of tracked_allocate()
+[[nodiscard]] std::size_t tracked_size(const void* pointer) noexcept {
+	return reinterpret_cast<const TrackedHeader*>(static_cast<const std::byte*>(pointer) - sizeof(TrackedHeader))->bytes;
+}
+
+void tracked_free(void* pointer) noexcept {
+	if (pointer == nullptr)
+		return;
+
+	const auto& header =
+			*reinterpret_cast<const TrackedHeader*>(static_cast<const std::byte*>(pointer) - sizeof(TrackedHeader));
+	auto& counters = tag_counters[std::to_underlying(header.tag)];
+	counters.deallocations.fetch_add(1, std::memory_order_relaxed);
+	counters.freed_bytes.fetch_add(header.bytes, std::memory_order_relaxed);
+	auto& thread_counters = thread_tag_counters[std::to_underlying(header.tag)];
+	++thread_counters.deallocations;
+	thread_counters.freed_bytes += header.bytes;
+	std::free(header.block);
+}
+
+// Checks that frames past a warm up do not touch the heap at all, the warm up leaves the containers that keep their
+// capacity, and the arenas of a FrameAllocator, time to grow to the steady state. Without WITH_ALLOCATION_TRACKING
+// every frame passes. Only the thread calling begin_frame() and end_frame() is checked, whatever the tags: the render
+// thread, the workers and the driver threads allocate on their own schedule and need a check of their own.
+class ZeroAllocationCheck {
+public:
+	explicit ZeroAllocationCheck(std::uint64_t warmup_frames = 120) noexcept : warmup_frames{warmup_frames} {}
+
+	void begin_frame() noexcept {
+		if constexpr (allocation_tracking)
+			frame_start = thread_allocation_stats();
+	}
+
+	// What the frame allocated, when it is past the warm up and allocated anything
+	[[nodiscard]] std::optional<AllocationStats> end_frame() noexcept {
+		if constexpr (allocation_tracking) {
+			if (frames++ < warmup_frames)
+				return std::nullopt;
+
+			const auto frame = thread_allocation_stats() - frame_start;
+			if (frame.total().allocations != 0)
+				return frame;
+		}
+		return std::nullopt;
+	}
+
+	[[nodiscard]] std::uint64_t frame_count() const noexcept {
+		return frames;
+	}
+
+private:
+	std::uint64_t warmup_frames;
+	std::uint64_t frames = 0;
+	AllocationStats frame_start;
+};
+
+// Fixed size blocks carved out of chunks requested from the upstream resource. A freed block goes on a free list and
+// is the next one handed out, so a pool serving one kind of allocation, like the pages of a storage, never fragments.
+// Requests bigger than a block, or more aligned than std::max_align_t, go straight to upstream.
+//
+// None of the resources of this module are synchronized: give each thread its own. Chunks are first touched by the
+// thread using the resource, so with the usual first touch policy their pages end up on that thread's NUMA node.
+class BlockPool final : public std::pmr::memory_resource {
+public:
+	explicit BlockPool(std::size_t block_size, std::size_t blocks_per_chunk = 64,
+										 std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+			: block_bytes{round_up(std::max(block_size, sizeof(FreeBlock)), max_alignment)},
+				chunk_bytes{chunk_header_bytes + block_bytes * std::max(blocks_per_chunk, 1uz)}, upstream{upstream} {}
+
+	BlockPool(const BlockPool&) = delete;
+	BlockPool& operator=(const BlockPool&) = delete;
+
+	~BlockPool() override {
+		release();
+	}
+
+	[[nodiscard]] std::size_t block_size() const noexcept {
+		return block_bytes;
+	}
+
+	// Gives every chunk back to upstream, all the blocks handed out become invalid
+	void release() noexcept {
+		while (chunks != nullptr)
+			upstream->deallocate(std::exchange(chunks, chunks->next), chunk_bytes, max_alignment);
+
+		free_blocks = nullptr;
+		cursor = nullptr;
+		chunk_end = nullptr;
+	}
+
+private:
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	struct ChunkHeader {
+		ChunkHeader* next;
+	};
+
+	static constexpr std::size_t chunk_header_bytes = round_up(sizeof(ChunkHeader), max_alignment);
+
+	[[nodiscard]] bool fits(std::size_t bytes, std::size_t alignment) const noexcept {
+		return bytes <= block_bytes and alignment <= max_alignment;
+	}
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+		if (not fits(bytes, alignment))
+			return upstream->allocate(bytes, alignment);
+
+		if (free_blocks != nullptr)
+			return std::exchange(free_blocks, free_blocks->next);
+
+		if (cursor == chunk_end) {
+			auto* chunk = static_cast<std::byte*>(upstream->allocate(chunk_bytes, max_alignment));
+			chunks = ::new (chunk) ChunkHeader{chunks};
+			cursor = chunk + chunk_header_bytes;
+			chunk_end = chunk + chunk_bytes;
+		}
+		return std::exchange(cursor, cursor + block_bytes);
+	}
+
+	void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override {
+		if (not fits(bytes, alignment))
+			return upstream->deallocate(pointer, bytes, alignment);
+
+		free_blocks = ::new (pointer) FreeBlock{free_blocks};
+	}
+
+	[[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+
+	std::size_t block_bytes;
+	std::size_t chunk_bytes;
+	std::pmr::memory_resource* upstream;
+
+	ChunkHeader* chunks = nullptr;
+	FreeBlock* free_blocks = nullptr;
+	// the part of the newest chunk no block was carved from yet
+	std::byte* cursor = nullptr;
+	std::byte* chunk_end = nullptr;
+};
+
+// One BlockPool per power of two from 16 bytes up to max_block_size, each request is served by the smallest block it
+// fits in. It suits containers whose sizes vary, like the sparse and packed arrays of the storages, and wastes at most
+// half a block per allocation. Bigger requests go to upstream.
+class PoolResource final : public std::pmr::memory_resource {
+public:
+	explicit PoolResource(std::size_t max_block_size = 64 * 1024,
+												std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+			: upstream{upstream} {
+		for (auto block_size = min_block_size; block_size <= max_block_size; block_size *= 2) {
+			// chunks of at least chunk_target bytes, and at least 4 blocks for the biggest classes
+			const auto blocks_per_chunk = std::max(chunk_target / block_size, 4uz);
+			pools.emplace_back(block_size, blocks_per_chunk, upstream);
+		}
+	}
+
+	PoolResource(const PoolResource&) = delete;
+	PoolResource& operator=(const PoolResource&) = delete;
+
+	void release() noexcept {
+		for (auto& pool : pools)
+			pool.release();
+	}
+
+private:
+	static constexpr std::size_t min_block_size = 16;
+	static constexpr std::size_t chunk_target = 64 * 1024;
+
+	[[nodiscard]] BlockPool* pool_for(std::size_t bytes, std::size_t alignment) noexcept {
+		if (alignment > max_alignment)
+			return nullptr;
+
+		const auto index = static_cast<std::size_t>(std::bit_width(std::max(bytes, min_block_size) - 1)) -
+											 static_cast<std::size_t>(std::countr_zero(min_block_size));
+		return index < pools.size() ? &pools[index] : nullptr;
+	}
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+		auto* pool = pool_for(bytes, alignment);
+		return pool ? pool->allocate(bytes, alignment) : upstream->allocate(bytes, alignment);
+	}
+
+	void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override {
+		if (auto* pool = pool_for(bytes, alignment))
+			pool->deallocate(pointer, bytes, alignment);
+		else
+			upstream->deallocate(pointer, bytes, alignment);
+	}
+
+	[[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+
+	std::pmr::memory_resource* upstream;
+	// a deque never moves its elements, BlockPool cannot be moved
+	std::deque<BlockPool> pools;
+};
+
+// Bump allocation in chunks requested from upstream. Deallocation does nothing, the memory comes back all at once with
+// reset() or release(), which suits data dying together: a loaded level, a scene, the temporaries of a frame.
+class Arena final : public std::pmr::memory_resource {
+public:
+	explicit Arena(std::size_t chunk_size = 64 * 1024,
+								 std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+			: chunk_size{chunk_size}, upstream{upstream} {}
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	~Arena() override {
+		release();
+	}
+
+	// Forgets every allocation and keeps the chunks for the next ones, in constant time
+	void reset() noexcept {
+		current = chunks;
+		cursor = current ? current->data() : nullptr;
+		used_bytes = 0;
+	}
+
+	// Forgets every allocation and gives the chunks back to upstream
+	void release() noexcept {
+		while (chunks != nullptr) {
+			auto* chunk = std::exchange(chunks, chunks->next);
+			upstream->deallocate(chunk, chunk_header_bytes + chunk->size, max_alignment);
+		}
+		current = nullptr;
+		cursor = nullptr;
+		used_bytes = 0;
+	}
+
+	// Bytes handed out since the last reset, padding included
+	[[nodiscard]] std::size_t used() const noexcept {
+		return used_bytes;
+	}
+
+private:
+	struct Chunk {
+		Chunk* next;
+		std::size_t size;
+
+		[[nodiscard]] std::byte* data() noexcept {
+			return reinterpret_cast<std::byte*>(this) + chunk_header_bytes;
+		}
+
+		[[nodiscard]] std::byte* end() noexcept {
+			return data() + size;
+		}
+	};
+
+	static constexpr std::size_t chunk_header_bytes = round_up(sizeof(Chunk), max_alignment);
+
+	// Aligns the cursor in the current chunk, nullptr when the request does not fit
+	[[nodiscard]] std::byte* bump(std::size_t bytes, std::size_t alignment) noexcept {
+		if (current == nullptr)
+			return nullptr;
+
+		const auto address = reinterpret_cast<std::uintptr_t>(cursor);
+		auto* aligned = cursor + (round_up(address, alignment) - address);
+		if (aligned > current->end() or bytes > static_cast<std::size_t>(current->end() - aligned))
+			return nullptr;
+
+		used_bytes += static_cast<std::size_t>(aligned - cursor) + bytes;
+		cursor = aligned + bytes;
+		return aligned;
+	}
+
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+		if (auto* pointer = bump(bytes, alignment))
+			return pointer;
+
+		// the chunks kept by reset() come first, a new one is added only when the request fits in none of them
+		while (current != nullptr and current->next != nullptr) {
+			current = current->next;
+			cursor = current->data();
+			if (auto* pointer = bump(bytes, alignment))
+				return pointer;
+		}
+
+		const auto size = std::max(chunk_size, bytes + alignment);
+		auto* chunk = ::new (upstream->allocate(chunk_header_bytes + size, max_alignment)) Chunk{nullptr, size};
+		if (current != nullptr)
+			current->next = chunk;
+		else
+			chunks = chunk;
+
+		current = chunk;
+		cursor = chunk->data();
+		return bump(bytes, alignment);
+	}
+
+	void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+	[[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+
+	std::size_t chunk_size;
+	std::pmr::memory_resource* upstream;
+
+	// in allocation order, reset() starts over from the first one
+	Chunk* chunks = nullptr;
+	Chunk* current = nullptr;
+	std::byte* cursor = nullptr;
+	std::size_t used_bytes = 0;
+};
+
+template <typename Type> using allocator = std::pmr::polymorphic_allocator<Type>;
+
+// Memory for the temporaries of a frame: one Arena per frame in flight, used in turn. next_frame() moves on to the
+// arena of the oldest frame and resets it in constant time, so what a frame allocated stays valid while the
+// frames_in_flight - 1 frames after it are still being worked on. Once the arenas grew to fit the biggest frame, frames
+// stop allocating from upstream.
+class FrameAllocator {
+public:
+	explicit FrameAllocator(std::size_t frames_in_flight = 2, std::size_t chunk_size = 64 * 1024,
+													std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) {
+		for (auto i = 0uz; i < std::max(frames_in_flight, 1uz); ++i)
+			arenas.emplace_back(chunk_size, upstream);
+	}
+
+	FrameAllocator(const FrameAllocator&) = delete;
+	FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+	// Call it at the frame boundary: the temporaries of the frame that was frames_in_flight frames ago are gone
+	void next_frame() noexcept {
+		current = current + 1 == arenas.size() ? 0 : current + 1;
+		arenas[current].reset();
+	}
+
+	[[nodiscard]] std::pmr::memory_resource* resource() noexcept {
+		return &arenas[current];
+	}
+
+	template <typename Type = std::byte> [[nodiscard]] allocator<Type> get_allocator() noexcept {
+		return allocator<Type>{resource()};
+	}
+
+	[[nodiscard]] std::size_t frames_in_flight() const noexcept {
+		return arenas.size();
+	}
+
+	// Bytes the current frame allocated so far
+	[[nodiscard]] std::size_t used() const noexcept {
+		return arenas[current].used();
+	}
+
+private:
+	// a deque never moves its elements, Arena cannot be moved
+	std::deque<Arena> arenas;
+	std::size_t current = 0;
+};
+
+// std::println formats into a std::string on the general heap, this one formats into a string of the given resource
+template <typename... Args>
+void println(std::pmr::memory_resource* resource, std::format_string<Args...> format, Args&&... args) {
+	std::pmr::string line{resource};
+	std::format_to(std::back_inserter(line), format, std::forward<Args>(args)...);
+	line.push_back('\n');
+	std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+}
+
+// A registry whose storages, pages and sparse arrays included, all allocate from the resource it is built with:
+// registry reg{allocator<ecs::entity>{&pool}};
+using registry = ecs::basic_registry<ecs::entity, allocator<ecs::entity>>;
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<>>
+using dense_map = ecs::dense_map<Key, Value, Hash, Equal, allocator<std::pair<const Key, Value>>>;
+
+template <typename Type, typename Hash = std::hash<Type>, typename Equal = std::equal_to<>>
+using dense_set = ecs::dense_set<Type, Hash, Equal, allocator<Type>>;
+
+} // namespace vis::memory
@@ -0,0 +1,167 @@
+export module vis.replay;
+
+import std;
+import vis.window;
+
+export namespace vis::replay {
+
+// LEB128: seven bits per byte, the high bit tells that another byte follows. Small values, like the ticks between two
+// key presses, take a single byte.
+void write_varint(std::vector<std::byte>& buffer, std::uint64_t value) {
+	while (value >= 0x80) {
+		buffer.push_back(static_cast<std::byte>(value | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back(static_cast<std::byte>(value));
+}
+
+// Decodes the varint at the front of bytes and drops it from the span
+[[nodiscard]] std::uint64_t read_varint(std::span<const std::byte>& bytes) {
+	std::uint64_t value = 0;
+	for (auto shift = 0u; shift < 64; shift += 7) {
+		if (bytes.empty())
+			throw std::runtime_error{"The recording is truncated"};
+
+		const auto byte = std::to_integer<std::uint64_t>(bytes.front());
+		bytes = bytes.subspan(1);
+		value |= (byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0)
+			return value;
+	}
+	throw std::runtime_error{"The recording holds a malformed varint"};
+}
+
+struct InputEvent {
+	// the event applies before this tick is simulated
+	std::uint64_t tick = 0;
+	win::VirtualKey key{};
+	bool pressed = false;
+};
+
+// Layout of a recording: the magic, then varints for the version, the random seed, the tick count and the event count,
+// then one event after the other as the ticks elapsed since the previous event and the key shifted left by one with
+// the pressed flag in the low bit.
+namespace recording_format {
+constexpr std::array magic{std::byte{'V'}, std::byte{'I'}, std::byte{'S'}, std::byte{'R'}};
+// bumped whenever the simulation plays the same input differently, an older recording would no longer replay its match
+//  2: the computer pad follows the predicted trajectory of the ball
+constexpr std::uint64_t version = 2;
+} // namespace recording_format
+
+// Logs what a deterministic simulation needs to run again: the seed of its random numbers and the input it received,
+// tick by tick. Only changes are recorded, a key held for a whole match costs two events.
+class InputRecorder {
+public:
+	explicit InputRecorder(std::uint64_t seed) noexcept : seed{seed} {}
+
+	// Ticks must not decrease from one call to the next
+	void record(std::uint64_t tick, win::VirtualKey key, bool pressed) {
+		write_varint(events, tick - last_tick);
+		write_varint(events, std::to_underlying(key) << 1 | (pressed ? 1u : 0u));
+		last_tick = tick;
+		++event_count;
+	}
+
+	// Sets how many ticks the replay runs, the recording ends after the last one
+	void finish(std::uint64_t ticks) noexcept {
+		tick_count = ticks;
+	}
+
+	[[nodiscard]] std::vector<std::byte> bytes() const {
+		std::vector<std::byte> buffer(recording_format::magic.begin(), recording_format::magic.end());
+		write_varint(buffer, recording_format::version);
+		write_varint(buffer, seed);
+		write_varint(buffer, tick_count);
+		write_varint(buffer, event_count);
+		buffer.insert(buffer.end(), events.begin(), events.end());
+		return buffer;
+	}
+
+	void save(const std::filesystem::path& path) const {
+		const auto buffer = bytes();
+		std::ofstream file{path, std::ios::binary | std::ios::trunc};
+		file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+		if (not file)
+			throw std::runtime_error{std::format("Unable to write {}", path.string())};
+	}
+
+private:
+	std::uint64_t seed;
+	std::uint64_t tick_count = 0;
+	std::uint64_t event_count = 0;
+	std::uint64_t last_tick = 0;
+	std::vector<std::byte> events;
+};
+
+// Plays back what InputRecorder saved. The driver seeds its random numbers with seed(), then before each tick drains
+// the events due with next().
+class InputReplay {
+public:
+	explicit InputReplay(std::vector<std::byte> recording) : buffer{std::move(recording)}, remaining{buffer} {
+		const auto magic_size = recording_format::magic.size();
+		if (remaining.size() < magic_size or not std::ranges::equal(remaining.first(magic_size), recording_format::magic))
+			throw std::runtime_error{"Not a vis input recording"};
+
+		remaining = remaining.subspan(magic_size);
+		if (read_varint(remaining) != recording_format::version)
+			throw std::runtime_error{"The input recording has another version"};
+
+		random_seed = read_varint(remaining);
+		ticks = read_varint(remaining);
+		events_left = read_varint(remaining);
+	}
+
+	[[nodiscard]] static InputReplay load(const std::filesystem::path& path) {
+		std::ifstream file{path, std::ios::binary | std::ios::ate};
+		if (not file)
+			throw std::runtime_error{std::format("Unable to open {}", path.string())};
+
+		std::vector<std::byte> recording(static_cast<std::size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(recording.data()), static_cast<std::streamsize>(recording.size()));
+		if (not file)
+			throw std::runtime_error{std::format("Unable to read {}", path.string())};
+
+		return InputReplay{std::move(recording)};
+	}
+
+	InputReplay(const InputReplay&) = delete;
+	InputReplay& operator=(const InputReplay&) = delete;
+
+	[[nodiscard]] std::uint64_t seed() const noexcept {
+		return random_seed;
+	}
+
+	[[nodiscard]] std::uint64_t tick_count() const noexcept {
+		return ticks;
+	}
+
+	// Pops the next event if it applies at or before tick
+	[[nodiscard]] std::optional<InputEvent> next(std::uint64_t tick) {
+		if (not pending and events_left != 0) {
+			--events_left;
+			const auto event_tick = last_tick + read_varint(remaining);
+			const auto code = read_varint(remaining);
+			last_tick = event_tick;
+			pending = InputEvent{.tick = event_tick, .key = win::VirtualKey{code >> 1}, .pressed = (code & 1) != 0};
+		}
+
+		if (not pending or pending->tick > tick)
+			return std::nullopt;
+
+		return std::exchange(pending, std::nullopt);
+	}
+
+private:
+	std::vector<std::byte> buffer;
+	// not decoded yet, points into buffer
+	std::span<const std::byte> remaining;
+
+	std::uint64_t random_seed = 0;
+	std::uint64_t ticks = 0;
+	std::uint64_t events_left = 0;
+	std::uint64_t last_tick = 0;
+	std::optional<InputEvent> pending;
+};
+
+} // namespace vis::replay
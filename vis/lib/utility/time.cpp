@@ -45,6 +45,102 @@ public:
 private:
 	clock::time_point start_time_point;
 };
+
+// Wall clock breakdown of the startup, phases can be measured from any thread. Times are relative to the first use of
+// the global trace, so it should be touched as early as possible. Startup is not a hot path, the phases are appended
+// under a mutex.
+class StartupTrace {
+public:
+	struct Phase {
+		std::string name;
+		std::thread::id thread;
+		milliseconds start{};
+		milliseconds duration{};
+	};
+
+	// Records the phase when it goes out of scope
+	class Scope {
+	public:
+		Scope(StartupTrace& trace, std::string_view name)
+				: trace{trace}, name{name}, start{std::chrono::steady_clock::now()} {}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		~Scope() {
+			trace.record(name, start, std::chrono::steady_clock::now());
+		}
+
+	private:
+		StartupTrace& trace;
+		std::string name;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	static StartupTrace& global() {
+		static StartupTrace trace;
+		return trace;
+	}
+
+	[[nodiscard]] Scope measure(std::string_view name) {
+		return Scope{*this, name};
+	}
+
+	// A milestone without duration, such as the first presented frame
+	milliseconds mark(std::string_view name) {
+		const auto now = std::chrono::steady_clock::now();
+		record(name, now, now);
+		return since_origin(now);
+	}
+
+	[[nodiscard]] std::vector<Phase> phases() const {
+		std::lock_guard lock{mutex};
+		return recorded;
+	}
+
+	// One line per phase in start order, threads are numbered in order of appearance
+	[[nodiscard]] std::string report() const {
+		auto sorted = phases();
+		std::ranges::stable_sort(sorted, {}, &Phase::start);
+
+		std::vector<std::thread::id> threads;
+		std::string result = "startup breakdown:";
+		for (const auto& phase : sorted) {
+			auto thread = std::ranges::find(threads, phase.thread);
+			if (thread == threads.end())
+				thread = threads.insert(thread, phase.thread);
+
+			result += std::format("\n  {:>9.2f}ms {:>9.2f}ms  thread {}  {}", phase.start.count(), phase.duration.count(),
+														std::distance(threads.begin(), thread), phase.name);
+		}
+		return result;
+	}
+
+private:
+	StartupTrace() : origin{std::chrono::steady_clock::now()} {}
+
+	void record(std::string_view name, std::chrono::steady_clock::time_point start,
+							std::chrono::steady_clock::time_point end) {
+		auto phase = Phase{
+				.name = std::string{name},
+				.thread = std::this_thread::get_id(),
+				.start = since_origin(start),
+				.duration = std::chrono::duration_cast<milliseconds>(end - start),
+		};
+
+		std::lock_guard lock{mutex};
+		recorded.push_back(std::move(phase));
+	}
+
+	milliseconds since_origin(std::chrono::steady_clock::time_point time_point) const noexcept {
+		return std::chrono::duration_cast<milliseconds>(time_point - origin);
+	}
+
+private:
+	std::chrono::steady_clock::time_point origin;
+	mutable std::mutex mutex;
+	std::vector<Phase> recorded;
+};
 } // namespace chrono
 
 inline namespace literals { inline namespace chrono_literals {
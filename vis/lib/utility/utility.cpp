@@ -7,19 +7,36 @@ import std;
 import vis.math;
 
 export namespace vis {
-// Function to generate a random float between min and max
-inline float get_random(float min, float max) {
-	static std::mt19937 rng(std::random_device{}());			// Random number generator
+// A fresh seed, different on every call, for instance for the engine a simulation owns
+inline std::uint32_t make_random_seed() {
+	return std::random_device{}();
+}
+
+// Engine behind the get_random() calls that take none, seeded once from the random device. Nothing drawn from it is
+// reproducible: a simulation that is replayed owns its engine, seeded with the seed of the recording.
+inline std::mt19937& random_engine() {
+	static std::mt19937 rng(make_random_seed());
+	return rng;
+}
+
+// Function to generate a random float between min and max, drawn from rng
+inline float get_random(std::mt19937& rng, float min, float max) {
 	std::uniform_real_distribution<float> dist(min, max); // Uniform distribution
 	return dist(rng);																			// Generate the random number
 }
 
+// Function to generate a random float between min and max
+inline float get_random(float min, float max) {
+	return get_random(random_engine(), min, max);
+}
+
 inline float get_random(float val) {
 	return get_random(-val, +val);
 }
 
-inline vec2 get_random_direction(vec2 vec, float min_angle, float max_angle) {
-	float a = get_random(min_angle, max_angle);
+// Simulations that are saved and restored, or that run side by side, own their engine and pass it here
+inline vec2 get_random_direction(std::mt19937& rng, vec2 vec, float min_angle, float max_angle) {
+	float a = get_random(rng, min_angle, max_angle);
 
 	mat4 rot = gtc::identity<mat4>();
 	rot = gtc::rotate(rot, a, vec3{vec.x, vec.y, 1.0f});
@@ -27,4 +44,8 @@ inline vec2 get_random_direction(vec2 vec, float min_angle, float max_angle) {
 
 	return normalize(vec2{rotated.x, rotated.y});
 }
+
+inline vec2 get_random_direction(vec2 vec, float min_angle, float max_angle) {
+	return get_random_direction(random_engine(), vec, min_angle, max_angle);
+}
 } // namespace vis
\ No newline at end of file
@@ -2,11 +2,21 @@ export module vis;
 
 export import vis.chrono;
 export import vis.math;
+export import vis.math.simd;
 export import vis.utility;
+export import vis.jobs;
+export import vis.replay;
+export import vis.memory;
+export import vis.net;
 export import vis.ecs;
+export import vis.ecs.archive;
+export import vis.ecs.command_buffer;
+export import vis.ecs.concurrent_dispatcher;
 export import vis.physic;
 export import vis.window;
 export import vis.app;
 export import vis.graphic.opengl;
 export import vis.graphic.mesh;
-export import vis.graphic.vulkan;
\ No newline at end of file
+export import vis.graphic.render_queue;
+export import vis.graphic.vulkan;
+export import vis.graphic.vulkan.render_thread;
\ No newline at end of file
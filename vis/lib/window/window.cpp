@@ -71,8 +71,12 @@ public:
 
   ~Window();
 
+  // Loads the Vulkan library once for the whole process. Only the first call has to come from the main thread, after it
+  // the renderer can create its instance on another thread, even before any window exists.
+  static void init_renderer_library();
+
   VkSurfaceKHR create_renderer_surface(VkInstance instance, const VkAllocationCallbacks* allocator) const;
-  std::vector<const char*> get_required_renderer_extension();
+  static std::vector<const char*> get_required_renderer_extension();
 
   explicit operator SDL_Window*() const noexcept {
     return window;
@@ -100,12 +104,20 @@ enum class VirtualKey : std::uint64_t {
 };
 enum class KeyMode : std::uint32_t {};
 
+// Nanoseconds since SDL was initialized, the clock SDL stamps its events with
+using Timestamp = std::chrono::nanoseconds;
+
+// The current time on the clock of the event timestamps
+[[nodiscard]] Timestamp ticks() noexcept;
+
 struct KeyboardKeyDownEvent {
   VirtualKey key; /**< SDL virtual key code */
   // KeyMode mod;		/**< current key modifiers */
 
   Pressed pressed;
   Repeated repeated;
+  // when the OS reported the key, not when the app got to it
+  Timestamp timestamp{};
 };
 
 struct KeyboardKeyUpEvent {
@@ -114,17 +126,27 @@ struct KeyboardKeyUpEvent {
 
   Pressed pressed;
   Repeated repeated;
+  Timestamp timestamp{};
 };
 
-struct QuitEvent {};
+struct QuitEvent {
+  Timestamp timestamp{};
+};
 
-struct NullEvent {};
+struct NullEvent {
+  Timestamp timestamp{};
+};
 
 struct WindowsResized {
   int width;
   int height;
+  Timestamp timestamp{};
 };
 
 using Event = std::variant<KeyboardKeyDownEvent, KeyboardKeyUpEvent, QuitEvent, WindowsResized, NullEvent>;
 
+[[nodiscard]] Timestamp timestamp(const Event& event) noexcept {
+  return std::visit([](const auto& alternative) { return alternative.timestamp; }, event);
+}
+
 } // namespace vis::win
@@ -13,12 +13,22 @@ namespace vis {
 
 Window::Window(std::string_view title, int width, int height, WindowsFlags flags) {
   using underlying = std::underlying_type<WindowsFlags>::type;
-  volkInitialize();
+  if ((static_cast<underlying>(flags) & static_cast<underlying>(WindowsFlags::vulkan)) != 0)
+    init_renderer_library();
   window = SDL_CreateWindow(title.data(), width, height, static_cast<underlying>(flags));
   if (not window)
     throw std::runtime_error(std::format("Unable to create window: {}", SDL_GetError()));
 }
 
+void Window::init_renderer_library() {
+  static std::once_flag loaded;
+  std::call_once(loaded, [] {
+    if (not SDL_InitSubSystem(SDL_INIT_VIDEO) or not SDL_Vulkan_LoadLibrary(nullptr))
+      throw std::runtime_error(std::format("Unable to load the Vulkan library: {}", SDL_GetError()));
+    volkInitialize();
+  });
+}
+
 void swap(Window& lhs, Window& rhs) {
   ::std::swap(lhs.window, rhs.window);
 }
@@ -61,3 +71,11 @@ std::vector<const char*> Window::get_required_renderer_extension() {
 }
 
 } // namespace vis
+
+namespace vis::win {
+
+Timestamp ticks() noexcept {
+  return Timestamp{static_cast<Timestamp::rep>(SDL_GetTicksNS())};
+}
+
+} // namespace vis::win